@@ -0,0 +1,587 @@
+#ifndef LIBIDRIL_BENCHMARK_COMMON_HPP
+#define LIBIDRIL_BENCHMARK_COMMON_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace idril::bench
+{
+/**
+ *  \brief Simple command line parser.
+ *
+ *  Options are expected in the form `--name value`, flags in the form
+ *  `--name`. Numeric values may use the scientific notation e.g., 1e6.
+ */
+class CommandLine
+{
+public:
+    CommandLine(int argc, char** argv) : args_(argv + 1, argv + argc)
+    {
+    }
+
+    /**
+     *  \brief Checks whether the \p flag is present
+     */
+    [[nodiscard]] auto has(std::string_view const flag) const -> bool
+    {
+        return std::find(args_.begin(), args_.end(), flag) != args_.end();
+    }
+
+    /**
+     *  \brief Returns value of the \p option or \p def if it is not present
+     */
+    [[nodiscard]] auto value(
+        std::string_view const option, std::string_view const def
+    ) const -> std::string
+    {
+        auto const it = std::find(args_.begin(), args_.end(), option);
+        if (it == args_.end() || it + 1 == args_.end())
+        {
+            return std::string(def);
+        }
+        return std::string(*(it + 1));
+    }
+
+    /**
+     *  \brief Returns numeric value of the \p option or \p def
+     */
+    [[nodiscard]] auto number(
+        std::string_view const option, std::uint64_t const def
+    ) const -> std::uint64_t
+    {
+        auto const str = this->value(option, "");
+        return str.empty() ? def
+                           : static_cast<std::uint64_t>(std::stod(str));
+    }
+
+    /**
+     *  \brief Returns comma separated values of the \p option
+     *  \return list of values, empty list if the option is not present
+     */
+    [[nodiscard]] auto list(std::string_view const option) const
+        -> std::vector<std::string>
+    {
+        auto result = std::vector<std::string>();
+        auto const str = this->value(option, "");
+        auto first = std::size_t(0);
+        while (first < str.size())
+        {
+            auto last = str.find(',', first);
+            if (last == std::string::npos)
+            {
+                last = str.size();
+            }
+            result.emplace_back(str.substr(first, last - first));
+            first = last + 1;
+        }
+        return result;
+    }
+
+private:
+    std::vector<std::string_view> args_;
+};
+
+/**
+ *  \brief Checks whether \p name passes the \p filter
+ *  Empty filter accepts everything.
+ */
+inline auto is_selected(
+    std::vector<std::string> const& filter, std::string_view const name
+) -> bool
+{
+    return filter.empty()
+        || std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+/**
+ *  \brief Prevents the compiler from optimizing away \p value
+ */
+template<class T>
+inline auto do_not_optimize(T const& value) -> void
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ *  \brief Monotonic stopwatch with nanosecond resolution.
+ */
+class Stopwatch
+{
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    Stopwatch() : start_(clock_t::now())
+    {
+    }
+
+    auto restart() -> void
+    {
+        start_ = clock_t::now();
+    }
+
+    [[nodiscard]] auto elapsed_ns() const -> double
+    {
+        return static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock_t::now() - start_
+            )
+                .count()
+        );
+    }
+
+private:
+    clock_t::time_point start_;
+};
+
+/**
+ *  \brief Reads the cycle counter
+ *
+ *  Uses serialized rdtsc on x86, the virtual counter on AArch64 and falls
+ *  back to the steady clock (nanoseconds) elsewhere.
+ */
+inline auto read_cycles() -> std::uint64_t
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    auto const cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+#elif defined(__aarch64__)
+    auto cycles = std::uint64_t();
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(cycles) : : "memory");
+    return cycles;
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+#endif
+}
+
+/**
+ *  \brief Histogram of latencies with bounded relative error.
+ *
+ *  Same bucketing as HdrHistogram: values below 2*S are counted exactly,
+ *  every larger power of two range is split into S linear sub-buckets.
+ *  With S = 32 the reported percentiles are within ~3% of the true value.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : counts_(BucketCount, 0)
+    {
+    }
+
+    auto record(std::uint64_t const value) -> void
+    {
+        ++counts_[bucket_index(value)];
+        ++count_;
+        sum_ += value;
+        max_  = std::max(max_, value);
+    }
+
+    [[nodiscard]] auto count() const -> std::uint64_t
+    {
+        return count_;
+    }
+
+    [[nodiscard]] auto max() const -> std::uint64_t
+    {
+        return max_;
+    }
+
+    [[nodiscard]] auto mean() const -> double
+    {
+        return count_ > 0 ? static_cast<double>(sum_)
+                                / static_cast<double>(count_)
+                          : 0.0;
+    }
+
+    /**
+     *  \brief Returns upper bound of the bucket with the \p p -th percentile
+     */
+    [[nodiscard]] auto percentile(double const p) const -> std::uint64_t
+    {
+        if (0 == count_)
+        {
+            return 0;
+        }
+
+        auto const rank = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(p * static_cast<double>(count_) + 0.5)
+        );
+        auto seen = std::uint64_t(0);
+        for (auto i = std::size_t(0); i < counts_.size(); ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+            {
+                return std::min(max_, bucket_upper(i));
+            }
+        }
+        return max_;
+    }
+
+private:
+    static constexpr auto SubBits  = 5;
+    static constexpr auto SubCount = std::uint64_t(1) << SubBits;
+    static constexpr auto BucketCount
+        = 2 * SubCount + (63 - SubBits) * SubCount;
+
+    static auto bucket_index(std::uint64_t const value) -> std::size_t
+    {
+        if (value < 2 * SubCount)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        auto const exponent = 63 - std::countl_zero(value);
+        auto const shift    = exponent - SubBits;
+        auto const top      = value >> shift;
+        return static_cast<std::size_t>(
+            2 * SubCount + (exponent - SubBits - 1) * SubCount
+            + (top - SubCount)
+        );
+    }
+
+    static auto bucket_upper(std::size_t const index) -> std::uint64_t
+    {
+        if (index < 2 * SubCount)
+        {
+            return index;
+        }
+        auto const j     = index - 2 * SubCount;
+        auto const shift = j / SubCount + 1;
+        auto const top   = j % SubCount + SubCount;
+        return ((top + 1) << shift) - 1;
+    }
+
+private:
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t count_ {0};
+    std::uint64_t sum_ {0};
+    std::uint64_t max_ {0};
+};
+
+/**
+ *  \brief Resets the peak resident set size of the process
+ *
+ *  Uses /proc/self/clear_refs (Linux >= 4.0). If it is not available
+ *  the peak is not reset and reported values are process-wide maxima.
+ */
+inline auto reset_peak_rss() -> void
+{
+    auto ofst = std::ofstream("/proc/self/clear_refs");
+    if (ofst)
+    {
+        ofst << "5";
+    }
+}
+
+/**
+ *  \brief Returns the peak resident set size of the process in bytes
+ */
+inline auto peak_rss() -> std::uint64_t
+{
+    auto ifst = std::ifstream("/proc/self/status");
+    auto line = std::string();
+    while (std::getline(ifst, line))
+    {
+        if (line.rfind("VmHWM:", 0) == 0)
+        {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+
+    auto usage = rusage();
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+/**
+ *  \brief Returns the \p p -th percentile (0 <= p <= 1) of \p samples
+ *  \param samples samples, will be partially reordered
+ */
+inline auto percentile(std::vector<double>& samples, double const p)
+    -> double
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    auto const last  = static_cast<double>(samples.size() - 1);
+    auto const index = static_cast<std::size_t>(p * last + 0.5);
+    std::nth_element(
+        samples.begin(),
+        samples.begin() + static_cast<std::ptrdiff_t>(index),
+        samples.end()
+    );
+    return samples[index];
+}
+
+/**
+ *  \brief Summary of a timed run.
+ */
+struct RunStats
+{
+    std::uint64_t ops_ {0};
+    double totalNs_ {0.0};
+    double p50_ {0.0};
+    double p90_ {0.0};
+    double p99_ {0.0};
+
+    [[nodiscard]] auto ops_per_sec() const -> double
+    {
+        return totalNs_ > 0.0 ? static_cast<double>(ops_) * 1e9 / totalNs_
+                              : 0.0;
+    }
+};
+
+/**
+ *  \brief Times operations in batches and records ns/op of each batch.
+ *
+ *  Timing each operation separately would be dominated by the clock
+ *  overhead so we only take a timestamp every \c batch_size operations.
+ *  Percentiles are computed over the batch averages.
+ */
+class BatchRecorder
+{
+public:
+    /**
+     *  \brief Performs \p ops calls of \p op(i) while timing them
+     */
+    template<class Op>
+    auto run(std::uint64_t const ops, Op op) -> void
+    {
+        auto const batch = std::clamp<std::uint64_t>(ops / 256, 16, 4096);
+        auto watch       = Stopwatch();
+        auto i           = std::uint64_t(0);
+        while (i < ops)
+        {
+            auto const last = std::min(ops, i + batch);
+            auto const n    = last - i;
+            watch.restart();
+            for (; i < last; ++i)
+            {
+                op(i);
+            }
+            auto const ns = watch.elapsed_ns();
+            totalNs_ += ns;
+            samples_.push_back(ns / static_cast<double>(n));
+        }
+        ops_ += ops;
+    }
+
+    /**
+     *  \brief Times single call of \p op that processes \p ops elements
+     */
+    template<class Op>
+    auto run_bulk(std::uint64_t const ops, Op op) -> void
+    {
+        auto const watch = Stopwatch();
+        op();
+        auto const ns = watch.elapsed_ns();
+        totalNs_ += ns;
+        samples_.push_back(
+            ns / static_cast<double>(std::max<std::uint64_t>(1, ops))
+        );
+        ops_ += ops;
+    }
+
+    [[nodiscard]] auto stats() -> RunStats
+    {
+        auto result     = RunStats();
+        result.ops_     = ops_;
+        result.totalNs_ = totalNs_;
+        result.p50_     = percentile(samples_, 0.50);
+        result.p90_     = percentile(samples_, 0.90);
+        result.p99_     = percentile(samples_, 0.99);
+        return result;
+    }
+
+private:
+    std::vector<double> samples_;
+    std::uint64_t ops_ {0};
+    double totalNs_ {0.0};
+};
+
+/**
+ *  \brief Distribution of generated keys.
+ */
+enum class KeyDistribution
+{
+    Uniform,
+    Ascending,
+    Descending,
+    FewUnique
+};
+
+inline constexpr auto KeyDistributions = std::array {
+    KeyDistribution::Uniform,
+    KeyDistribution::Ascending,
+    KeyDistribution::Descending,
+    KeyDistribution::FewUnique
+};
+
+inline auto to_string(KeyDistribution const dist) -> std::string_view
+{
+    switch (dist)
+    {
+    case KeyDistribution::Uniform:
+        return "uniform";
+    case KeyDistribution::Ascending:
+        return "ascending";
+    case KeyDistribution::Descending:
+        return "descending";
+    case KeyDistribution::FewUnique:
+        return "few-unique";
+    }
+    return "?";
+}
+
+/**
+ *  \brief Largest generated key. Keys fit into 31 bits so that they can
+ *  be stored in any of the benchmarked element types.
+ */
+inline constexpr auto MaxKey = std::uint64_t((1u << 31) - 1);
+
+/**
+ *  \brief Generates \p n keys with given distribution
+ */
+inline auto generate_keys(
+    KeyDistribution const dist, std::uint64_t const n, std::uint64_t const seed
+) -> std::vector<std::uint64_t>
+{
+    auto rng  = std::mt19937_64(seed);
+    auto keys = std::vector<std::uint64_t>();
+    keys.reserve(n);
+    auto const step = std::max<std::uint64_t>(1, MaxKey / (n + 1) / 2);
+    switch (dist)
+    {
+    case KeyDistribution::Uniform:
+        for (auto i = std::uint64_t(0); i < n; ++i)
+        {
+            keys.push_back(rng() % MaxKey);
+        }
+        break;
+
+    case KeyDistribution::Ascending:
+        for (auto i = std::uint64_t(0); i < n; ++i)
+        {
+            keys.push_back((i * 2 * step + rng() % step) % MaxKey);
+        }
+        break;
+
+    case KeyDistribution::Descending:
+        for (auto i = std::uint64_t(0); i < n; ++i)
+        {
+            keys.push_back(MaxKey - (i * 2 * step + rng() % step) % MaxKey);
+        }
+        break;
+
+    case KeyDistribution::FewUnique:
+        for (auto i = std::uint64_t(0); i < n; ++i)
+        {
+            keys.push_back(rng() % 64);
+        }
+        break;
+    }
+    return keys;
+}
+
+/**
+ *  \brief Element with a key and a cache line worth of payload.
+ */
+struct Record
+{
+    std::uint64_t key_;
+    std::array<std::uint64_t, 7> payload_;
+
+    friend auto operator<(Record const& l, Record const& r) -> bool
+    {
+        return l.key_ < r.key_;
+    }
+};
+
+/**
+ *  \brief Maps benchmark keys to element types and back.
+ */
+template<class T>
+struct ElementTraits;
+
+template<>
+struct ElementTraits<std::uint32_t>
+{
+    static constexpr auto Name = std::string_view("u32");
+
+    static auto make(std::uint64_t const key) -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(key);
+    }
+
+    static auto key(std::uint32_t const elem) -> std::uint64_t
+    {
+        return elem;
+    }
+};
+
+template<>
+struct ElementTraits<std::uint64_t>
+{
+    static constexpr auto Name = std::string_view("u64");
+
+    static auto make(std::uint64_t const key) -> std::uint64_t
+    {
+        return key;
+    }
+
+    static auto key(std::uint64_t const elem) -> std::uint64_t
+    {
+        return elem;
+    }
+};
+
+template<>
+struct ElementTraits<Record>
+{
+    static constexpr auto Name = std::string_view("record64");
+
+    static auto make(std::uint64_t const key) -> Record
+    {
+        return Record {key, {key, key, key, key, key, key, key}};
+    }
+
+    static auto key(Record const& elem) -> std::uint64_t
+    {
+        return elem.key_;
+    }
+};
+
+/**
+ *  \brief Formats byte count as MiB
+ */
+inline auto to_mib(std::uint64_t const bytes) -> double
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+} // namespace idril::bench
+
+#endif
@@ -0,0 +1,565 @@
+/**
+ *  Graph benchmark.
+ *
+ *  Runs Dijkstra's shortest path and Prim's minimum spanning tree
+ *  algorithms with each heap. Unlike the heap benchmark the access
+ *  pattern of decrease_key is driven by the graph structure.
+ *
+ *  Usage: idril_graph_benchmark [options]
+ *    --graph FILE      DIMACS shortest path (.gr) file to load
+ *    --gen a,b         synthetic graphs to generate if no file is given,
+ *                      grid, random, powerlaw (default all)
+ *    --vertices N      number of vertices of generated graphs (default 1e5)
+ *    --degree N        average degree of generated graphs (default 8)
+ *    --sources N       number of source vertices for Dijkstra (default 4)
+ *    --heap a,b        heaps to run (default all)
+ *    --algo a,b        dijkstra, prim (default both)
+ *    --seed N          seed of the random generator (default 42)
+ *    --csv             print results as CSV
+ */
+
+#include "common.hpp"
+#include "heap_adapters.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace idril::bench
+{
+/**
+ *  \brief Weighted graph in the compressed sparse row format.
+ */
+struct Graph
+{
+    std::string name_;
+    std::vector<std::uint64_t> offsets_;
+    std::vector<std::uint32_t> targets_;
+    std::vector<std::uint32_t> weights_;
+
+    [[nodiscard]] auto vertex_count() const -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(offsets_.size() - 1);
+    }
+
+    [[nodiscard]] auto arc_count() const -> std::uint64_t
+    {
+        return targets_.size();
+    }
+};
+
+/**
+ *  \brief Weighted arc.
+ */
+struct Arc
+{
+    std::uint32_t from_;
+    std::uint32_t to_;
+    std::uint32_t weight_;
+};
+
+/**
+ *  \brief Builds CSR graph from an arc list
+ */
+auto make_graph(
+    std::string name, std::uint32_t const vertexCount, std::vector<Arc> arcs
+) -> Graph
+{
+    std::sort(arcs.begin(), arcs.end(), [](Arc const& l, Arc const& r)
+    {
+        return std::tie(l.from_, l.to_) < std::tie(r.from_, r.to_);
+    });
+
+    auto graph  = Graph();
+    graph.name_ = std::move(name);
+    graph.offsets_.assign(vertexCount + 1, 0);
+    graph.targets_.reserve(arcs.size());
+    graph.weights_.reserve(arcs.size());
+    for (auto const& arc : arcs)
+    {
+        ++graph.offsets_[arc.from_ + 1];
+        graph.targets_.push_back(arc.to_);
+        graph.weights_.push_back(arc.weight_);
+    }
+    for (auto v = std::uint32_t(0); v < vertexCount; ++v)
+    {
+        graph.offsets_[v + 1] += graph.offsets_[v];
+    }
+    return graph;
+}
+
+/**
+ *  \brief Adds both arcs of an undirected edge
+ */
+auto add_edge(
+    std::vector<Arc>& arcs,
+    std::uint32_t const u,
+    std::uint32_t const v,
+    std::uint32_t const weight
+) -> void
+{
+    arcs.push_back(Arc {u, v, weight});
+    arcs.push_back(Arc {v, u, weight});
+}
+
+/**
+ *  \brief Loads graph in the DIMACS shortest path format
+ *
+ *  Lines starting with 'c' are comments, the problem line is
+ *  "p sp <vertices> <arcs>" and each arc is "a <from> <to> <weight>"
+ *  with vertices numbered from 1. Prim's algorithm expects that both
+ *  directions of each edge are listed, as they are in the road networks
+ *  of the 9th DIMACS challenge.
+ */
+auto load_dimacs(std::string const& path) -> Graph
+{
+    auto ifst = std::ifstream(path);
+    if (not ifst)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    auto vertexCount = std::uint32_t(0);
+    auto arcs        = std::vector<Arc>();
+    auto line        = std::string();
+    while (std::getline(ifst, line))
+    {
+        if (line.empty() || line[0] == 'c')
+        {
+            continue;
+        }
+
+        auto istr = std::istringstream(line);
+        auto kind = char();
+        istr >> kind;
+        if (kind == 'p')
+        {
+            auto format   = std::string();
+            auto arcCount = std::uint64_t(0);
+            istr >> format >> vertexCount >> arcCount;
+            arcs.reserve(arcCount);
+        }
+        else if (kind == 'a')
+        {
+            auto arc = Arc();
+            istr >> arc.from_ >> arc.to_ >> arc.weight_;
+            if (arc.from_ == 0 || arc.from_ > vertexCount || arc.to_ == 0
+                || arc.to_ > vertexCount)
+            {
+                throw std::runtime_error("Invalid arc: " + line);
+            }
+            --arc.from_;
+            --arc.to_;
+            arcs.push_back(arc);
+        }
+    }
+
+    return make_graph(path, vertexCount, std::move(arcs));
+}
+
+/**
+ *  \brief Generates 4-connected grid with random weights
+ */
+auto generate_grid(std::uint32_t const vertexCount, std::uint64_t const seed)
+    -> Graph
+{
+    auto rng  = std::mt19937_64(seed);
+    auto side = std::uint32_t(1);
+    while (side * side < vertexCount)
+    {
+        ++side;
+    }
+
+    auto arcs = std::vector<Arc>();
+    arcs.reserve(4 * std::uint64_t(side) * side);
+    for (auto row = std::uint32_t(0); row < side; ++row)
+    {
+        for (auto col = std::uint32_t(0); col < side; ++col)
+        {
+            auto const v = row * side + col;
+            if (col + 1 < side)
+            {
+                add_edge(arcs, v, v + 1, 1 + rng() % 100);
+            }
+            if (row + 1 < side)
+            {
+                add_edge(arcs, v, v + side, 1 + rng() % 100);
+            }
+        }
+    }
+    return make_graph("grid", side * side, std::move(arcs));
+}
+
+/**
+ *  \brief Generates connected random graph with given average degree
+ *
+ *  A random spanning path guarantees connectivity, remaining edges
+ *  connect uniformly chosen pairs of vertices.
+ */
+auto generate_random(
+    std::uint32_t const vertexCount,
+    std::uint32_t const degree,
+    std::uint64_t const seed
+) -> Graph
+{
+    auto rng   = std::mt19937_64(seed);
+    auto order = std::vector<std::uint32_t>(vertexCount);
+    std::iota(order.begin(), order.end(), std::uint32_t(0));
+    std::shuffle(order.begin(), order.end(), rng);
+
+    auto const edgeCount = std::uint64_t(vertexCount) * degree / 2;
+    auto arcs = std::vector<Arc>();
+    arcs.reserve(2 * edgeCount);
+    for (auto i = std::uint32_t(1); i < vertexCount; ++i)
+    {
+        add_edge(arcs, order[i - 1], order[i], 1 + rng() % 1000);
+    }
+    for (auto i = std::uint64_t(vertexCount); i < edgeCount; ++i)
+    {
+        auto const u = static_cast<std::uint32_t>(rng() % vertexCount);
+        auto const v = static_cast<std::uint32_t>(rng() % vertexCount);
+        add_edge(arcs, u, v, 1 + rng() % 1000);
+    }
+    return make_graph("random", vertexCount, std::move(arcs));
+}
+
+/**
+ *  \brief Generates scale-free graph using preferential attachment
+ *
+ *  Barabasi-Albert model, each new vertex connects to degree/2 existing
+ *  vertices chosen with probability proportional to their degree.
+ */
+auto generate_powerlaw(
+    std::uint32_t const vertexCount,
+    std::uint32_t const degree,
+    std::uint64_t const seed
+) -> Graph
+{
+    auto rng       = std::mt19937_64(seed);
+    auto const m   = std::max<std::uint32_t>(1, degree / 2);
+    auto arcs      = std::vector<Arc>();
+    auto endpoints = std::vector<std::uint32_t>();
+    arcs.reserve(2 * std::uint64_t(vertexCount) * m);
+    endpoints.reserve(2 * std::uint64_t(vertexCount) * m);
+
+    // Start with a small clique.
+    auto const seedCount = std::min(vertexCount, m + 1);
+    for (auto u = std::uint32_t(0); u < seedCount; ++u)
+    {
+        for (auto v = u + 1; v < seedCount; ++v)
+        {
+            add_edge(arcs, u, v, 1 + rng() % 1000);
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+
+    for (auto v = seedCount; v < vertexCount; ++v)
+    {
+        for (auto i = std::uint32_t(0); i < m; ++i)
+        {
+            auto const u = endpoints.empty()
+                             ? 0
+                             : endpoints[rng() % endpoints.size()];
+            add_edge(arcs, u, v, 1 + rng() % 1000);
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+    return make_graph("powerlaw", vertexCount, std::move(arcs));
+}
+
+/**
+ *  \brief Heap element, tentative distance or edge weight and a vertex.
+ */
+struct VertexEntry
+{
+    std::uint64_t key_;
+    std::uint32_t vertex_;
+
+    friend auto operator<(VertexEntry const& l, VertexEntry const& r)
+        -> bool
+    {
+        return l.key_ < r.key_;
+    }
+};
+
+/**
+ *  \brief Counters collected during a single run.
+ */
+struct GraphStats
+{
+    std::uint64_t relaxed_ {0};
+    std::uint64_t inserts_ {0};
+    std::uint64_t decreaseKeys_ {0};
+    std::uint64_t deleteMins_ {0};
+    std::uint64_t checksum_ {0};
+    double totalNs_ {0.0};
+};
+
+/**
+ *  \brief State of a vertex during the search.
+ */
+enum class State : std::uint8_t
+{
+    Unseen,
+    Queued,
+    Done
+};
+
+/**
+ *  \brief Best known key of a vertex and its state.
+ */
+struct VertexLabel
+{
+    std::uint64_t key_ {0};
+    State state_ {State::Unseen};
+};
+
+/**
+ *  \brief Shared implementation of Dijkstra's and Prim's algorithm
+ *
+ *  Both algorithms only differ in the key of relaxed vertex.
+ *  Dijkstra uses distance of the vertex plus the edge weight,
+ *  Prim uses only the edge weight. Sum of the final keys of all reached
+ *  vertices is added to the checksum so that results of different heaps
+ *  can be compared.
+ */
+template<class Adapter, bool IsPrim>
+auto search(
+    Graph const& graph, std::uint32_t const source, GraphStats& stats
+) -> void
+{
+    using handle_t = typename Adapter::handle_type;
+
+    auto const n  = graph.vertex_count();
+    auto labels   = std::vector<VertexLabel>(n);
+    auto handles  = std::vector<std::optional<handle_t>>(n);
+    auto heap     = Adapter();
+    auto checksum = std::uint64_t(0);
+    auto watch    = Stopwatch();
+
+    handles[source]       = heap.insert(VertexEntry {0, source});
+    labels[source].state_ = State::Queued;
+    ++stats.inserts_;
+
+    while (heap.size() > 0)
+    {
+        auto const [key, u] = heap.find_min();
+        heap.delete_min();
+        ++stats.deleteMins_;
+        labels[u].state_  = State::Done;
+        checksum         += key;
+
+        auto const first = graph.offsets_[u];
+        auto const last  = graph.offsets_[u + 1];
+        for (auto i = first; i < last; ++i)
+        {
+            auto const v = graph.targets_[i];
+            if (labels[v].state_ == State::Done)
+            {
+                continue;
+            }
+
+            ++stats.relaxed_;
+            auto const weight = std::uint64_t(graph.weights_[i]);
+            auto const newKey = IsPrim ? weight : key + weight;
+            if (labels[v].state_ == State::Unseen)
+            {
+                labels[v].key_   = newKey;
+                labels[v].state_ = State::Queued;
+                handles[v]       = heap.insert(VertexEntry {newKey, v});
+                ++stats.inserts_;
+            }
+            else if (newKey < labels[v].key_)
+            {
+                labels[v].key_ = newKey;
+                heap.decrease_key(*handles[v], VertexEntry {newKey, v});
+                ++stats.decreaseKeys_;
+            }
+        }
+    }
+
+    stats.totalNs_  += watch.elapsed_ns();
+    stats.checksum_ += checksum;
+}
+
+/**
+ *  \brief Formats and prints results.
+ */
+class GraphReporter
+{
+public:
+    explicit GraphReporter(bool const csv) : csv_(csv)
+    {
+    }
+
+    auto header() const -> void
+    {
+        if (csv_)
+        {
+            std::printf(
+                "heap,graph,algo,vertices,arcs,total_ms,relaxed,inserts,"
+                "decrease_keys,delete_mins,ns_per_relaxed,checksum\n"
+            );
+        }
+        else
+        {
+            std::printf(
+                "%-18s %-10s %-9s %10s %11s %10s %12s %12s %12s %12s %9s"
+                " %16s\n",
+                "heap", "graph", "algo", "vertices", "arcs", "total ms",
+                "relaxed", "insert", "dec_key", "delete_min", "ns/edge",
+                "checksum"
+            );
+        }
+    }
+
+    auto row(
+        std::string_view const heap,
+        Graph const& graph,
+        std::string_view const algo,
+        GraphStats const& stats
+    ) const -> void
+    {
+        auto const nsPerEdge
+            = stats.relaxed_ > 0
+                ? stats.totalNs_ / static_cast<double>(stats.relaxed_)
+                : 0.0;
+        auto const* const format
+            = csv_ ? "%.*s,%s,%.*s,%u,%llu,%.2f,%llu,%llu,%llu,%llu,%.2f,%llu\n"
+                   : "%-18.*s %-10s %-9.*s %10u %11llu %10.2f %12llu %12llu"
+                     " %12llu %12llu %9.2f %16llu\n";
+        std::printf(
+            format,
+            static_cast<int>(heap.size()), heap.data(),
+            graph.name_.c_str(),
+            static_cast<int>(algo.size()), algo.data(),
+            graph.vertex_count(),
+            static_cast<unsigned long long>(graph.arc_count()),
+            stats.totalNs_ / 1e6,
+            static_cast<unsigned long long>(stats.relaxed_),
+            static_cast<unsigned long long>(stats.inserts_),
+            static_cast<unsigned long long>(stats.decreaseKeys_),
+            static_cast<unsigned long long>(stats.deleteMins_),
+            nsPerEdge,
+            static_cast<unsigned long long>(stats.checksum_)
+        );
+        std::fflush(stdout);
+    }
+
+private:
+    bool csv_;
+};
+
+/**
+ *  \brief Selection of what should be run.
+ */
+struct GraphSelection
+{
+    std::vector<std::string> heaps_;
+    std::vector<std::string> algos_;
+    std::uint32_t sources_;
+    std::uint64_t seed_;
+};
+
+template<template<class> class Adapter>
+auto run_heap(
+    std::string_view const heapName,
+    Graph const& graph,
+    GraphSelection const& sel,
+    GraphReporter const& reporter
+) -> void
+{
+    if (not is_selected(sel.heaps_, heapName) || graph.vertex_count() == 0)
+    {
+        return;
+    }
+
+    if (is_selected(sel.algos_, "dijkstra"))
+    {
+        auto rng   = std::mt19937_64(sel.seed_);
+        auto stats = GraphStats();
+        for (auto i = std::uint32_t(0); i < sel.sources_; ++i)
+        {
+            auto const source
+                = static_cast<std::uint32_t>(rng() % graph.vertex_count());
+            search<Adapter<VertexEntry>, false>(graph, source, stats);
+        }
+        reporter.row(heapName, graph, "dijkstra", stats);
+    }
+
+    if (is_selected(sel.algos_, "prim"))
+    {
+        auto stats = GraphStats();
+        search<Adapter<VertexEntry>, true>(graph, 0, stats);
+        reporter.row(heapName, graph, "prim", stats);
+    }
+}
+
+auto run_graph(
+    Graph const& graph,
+    GraphSelection const& sel,
+    GraphReporter const& reporter
+) -> void
+{
+    run_heap<PairingTwoPass>("pairing", graph, sel, reporter);
+    run_heap<PairingFifo>("pairing-fifo", graph, sel, reporter);
+    run_heap<PairingMultipass>("pairing-multipass", graph, sel, reporter);
+    run_heap<PairingAux>("pairing-aux", graph, sel, reporter);
+    run_heap<PairingPool>("pairing-pool", graph, sel, reporter);
+    run_heap<PairingIntrusive>("pairing-intrusive", graph, sel, reporter);
+    run_heap<Brodal>("brodal", graph, sel, reporter);
+    run_heap<BrodalRelaxed>("brodal-relaxed", graph, sel, reporter);
+    run_heap<Stl>("stl", graph, sel, reporter);
+}
+} // namespace idril::bench
+
+auto main(int argc, char** argv) -> int
+{
+    using namespace idril::bench;
+
+    auto const cmd = CommandLine(argc, argv);
+    auto sel       = GraphSelection();
+    sel.heaps_     = cmd.list("--heap");
+    sel.algos_     = cmd.list("--algo");
+    sel.sources_   = static_cast<std::uint32_t>(cmd.number("--sources", 4));
+    sel.seed_      = cmd.number("--seed", 42);
+
+    auto const reporter = GraphReporter(cmd.has("--csv"));
+    auto const path     = cmd.value("--graph", "");
+    if (not path.empty())
+    {
+        reporter.header();
+        run_graph(load_dimacs(path), sel, reporter);
+        return 0;
+    }
+
+    auto const gens = cmd.list("--gen");
+    auto const n = static_cast<std::uint32_t>(cmd.number("--vertices", 1e5));
+    auto const d = static_cast<std::uint32_t>(cmd.number("--degree", 8));
+    reporter.header();
+    if (is_selected(gens, "grid"))
+    {
+        run_graph(generate_grid(n, sel.seed_), sel, reporter);
+    }
+    if (is_selected(gens, "random"))
+    {
+        run_graph(generate_random(n, d, sel.seed_), sel, reporter);
+    }
+    if (is_selected(gens, "powerlaw"))
+    {
+        run_graph(generate_powerlaw(n, d, sel.seed_), sel, reporter);
+    }
+
+    return 0;
+}
@@ -0,0 +1,547 @@
+#ifndef LIBIDRIL_BENCHMARK_HEAP_ADAPTERS_HPP
+#define LIBIDRIL_BENCHMARK_HEAP_ADAPTERS_HPP
+
+#include "brodal_queue.hpp"
+#include "intrusive_pairing_heap.hpp"
+#include "pairing_heap.hpp"
+#include "pool_allocator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace idril::bench
+{
+/**
+ *  \brief Uniform interface over the benchmarked heaps.
+ *
+ *  Each adapter provides:
+ *  insert(value) -> handle_type
+ *  assign(values), replaces the content
+ *  insert_range(values, handles)
+ *  find_min() -> T const&
+ *  delete_min()
+ *  decrease_key(handle, newValue)
+ *  increase_key(handle&, newValue), may change the handle
+ *  erase(handle)
+ *  meld(other)
+ *  size()
+ */
+
+/**
+ *  \brief Adapter for idril::PairingHeap.
+ */
+template<class Heap>
+class PairingAdapter
+{
+public:
+    using value_type  = typename Heap::value_type;
+    using handle_type = typename Heap::handle_type;
+
+    auto insert(value_type const& value) -> handle_type
+    {
+        return heap_.insert(value);
+    }
+
+    auto assign(std::vector<value_type> const& values) -> void
+    {
+        heap_.assign(std::begin(values), std::end(values));
+    }
+
+    auto insert_range(
+        std::span<value_type const> const values,
+        std::span<handle_type> const handles
+    ) -> void
+    {
+        heap_.insert_range(values, handles);
+    }
+
+    auto find_min() -> value_type const&
+    {
+        return heap_.find_min();
+    }
+
+    auto delete_min() -> void
+    {
+        heap_.delete_min();
+    }
+
+    auto decrease_key(handle_type const handle, value_type const& value)
+        -> void
+    {
+        heap_.get_handle_data(handle) = value;
+        heap_.decrease_key(handle);
+    }
+
+    auto increase_key(handle_type const& handle, value_type const& value)
+        -> void
+    {
+        heap_.get_handle_data(handle) = value;
+        heap_.increase_key(handle);
+    }
+
+    auto erase(handle_type const handle) -> void
+    {
+        heap_.erase(handle);
+    }
+
+    auto meld(PairingAdapter& other) -> void
+    {
+        heap_.meld(std::move(other.heap_));
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+        return heap_.size();
+    }
+
+private:
+    Heap heap_;
+};
+
+/**
+ *  \brief Adapter for idril::IntrusivePairingHeap.
+ *
+ *  Elements live in geometrically growing blocks owned by the adapter
+ *  the way user objects would live in their own pools. Handles point to
+ *  the elements. Meld takes over the blocks of the other adapter.
+ */
+template<class T, class MergeMode>
+class IntrusiveAdapter
+{
+public:
+    struct Element : PairingHook
+    {
+        T value_;
+    };
+
+    using value_type  = T;
+    using handle_type = Element*;
+
+    auto insert(value_type const& value) -> handle_type
+    {
+        auto* const element = this->acquire();
+        element->value_     = value;
+        heap_.insert(*element);
+        return element;
+    }
+
+    auto assign(std::vector<value_type> const& values) -> void
+    {
+        *this = IntrusiveAdapter();
+        for (auto const& value : values)
+        {
+            this->insert(value);
+        }
+    }
+
+    auto insert_range(
+        std::span<value_type const> const values,
+        std::span<handle_type> const handles
+    ) -> void
+    {
+        for (auto i = std::size_t(0); i < values.size(); ++i)
+        {
+            handles[i] = this->insert(values[i]);
+        }
+    }
+
+    auto find_min() -> value_type const&
+    {
+        return heap_.find_min().value_;
+    }
+
+    auto delete_min() -> void
+    {
+        auto& element = heap_.find_min();
+        heap_.delete_min();
+        freeElements_.push_back(&element);
+    }
+
+    auto decrease_key(handle_type const handle, value_type const& value)
+        -> void
+    {
+        handle->value_ = value;
+        heap_.decrease_key(*handle);
+    }
+
+    auto increase_key(handle_type const handle, value_type const& value)
+        -> void
+    {
+        handle->value_ = value;
+        heap_.increase_key(*handle);
+    }
+
+    auto erase(handle_type const handle) -> void
+    {
+        heap_.erase(*handle);
+        freeElements_.push_back(handle);
+    }
+
+    auto meld(IntrusiveAdapter& other) -> void
+    {
+        heap_.meld(std::move(other.heap_));
+
+        // Blocks and free elements of the smaller vectors are appended
+        // to the larger ones, so free elements of both adapters are
+        // reused.
+        if (blocks_.size() < other.blocks_.size())
+        {
+            blocks_.swap(other.blocks_);
+        }
+        if (freeElements_.size() < other.freeElements_.size())
+        {
+            freeElements_.swap(other.freeElements_);
+        }
+
+        blocks_.insert(
+            std::end(blocks_),
+            std::make_move_iterator(std::begin(other.blocks_)),
+            std::make_move_iterator(std::end(other.blocks_))
+        );
+        freeElements_.insert(
+            std::end(freeElements_),
+            std::begin(other.freeElements_),
+            std::end(other.freeElements_)
+        );
+        other.blocks_.clear();
+        other.freeElements_.clear();
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+        return heap_.size();
+    }
+
+private:
+    struct ElementLess
+    {
+        auto operator()(Element const& l, Element const& r) const -> bool
+        {
+            return l.value_ < r.value_;
+        }
+    };
+
+    static constexpr auto FirstBlockSize = std::size_t(16);
+    static constexpr auto MaxBlockSize   = std::size_t(1024);
+
+private:
+    auto acquire() -> Element*
+    {
+        if (freeElements_.empty())
+        {
+            auto const count = blockSize_;
+            blockSize_       = std::min(MaxBlockSize, 2 * blockSize_);
+            blocks_.push_back(std::make_unique<Element[]>(count));
+            for (auto i = count; i > 0; --i)
+            {
+                freeElements_.push_back(&blocks_.back()[i - 1]);
+            }
+        }
+
+        auto* const element = freeElements_.back();
+        freeElements_.pop_back();
+        return element;
+    }
+
+private:
+    IntrusivePairingHeap<
+        Element,
+        PairingBaseHook<Element>,
+        ElementLess,
+        MergeMode>
+        heap_;
+    std::vector<std::unique_ptr<Element[]>> blocks_;
+    std::vector<Element*> freeElements_;
+    std::size_t blockSize_ {FirstBlockSize};
+};
+
+/**
+ *  \brief Adapter for idril::brodal_queue.
+ */
+template<class Queue>
+class BrodalAdapter
+{
+public:
+    using value_type  = typename Queue::value_type;
+    using handle_type = typename Queue::handle_t;
+
+    auto insert(value_type const& value) -> handle_type
+    {
+        return queue_.insert(value);
+    }
+
+    auto assign(std::vector<value_type> const& values) -> void
+    {
+        queue_ = Queue(std::begin(values), std::end(values));
+    }
+
+    auto insert_range(
+        std::span<value_type const> const values,
+        std::span<handle_type> const handles
+    ) -> void
+    {
+        for (auto i = std::size_t(0); i < values.size(); ++i)
+        {
+            handles[i] = this->insert(values[i]);
+        }
+    }
+
+    auto find_min() -> value_type const&
+    {
+        return queue_.find_min();
+    }
+
+    auto delete_min() -> void
+    {
+        queue_.delete_min();
+    }
+
+    auto decrease_key(handle_type handle, value_type const& value) -> void
+    {
+        *handle = value;
+        queue_.decrease_key(handle);
+    }
+
+    /**
+     *  \brief brodal_queue has no increase_key so the element is reinserted
+     */
+    auto increase_key(handle_type& handle, value_type const& value) -> void
+    {
+        queue_.erase(handle);
+        handle = queue_.insert(value);
+    }
+
+    auto erase(handle_type const handle) -> void
+    {
+        queue_.erase(handle);
+    }
+
+    auto meld(BrodalAdapter& other) -> void
+    {
+        queue_.meld(std::move(other.queue_));
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+        return queue_.size();
+    }
+
+private:
+    Queue queue_;
+};
+
+/**
+ *  \brief Adapter for std::priority_queue.
+ *
+ *  The standard queue has no handles so decrease_key and erase are
+ *  implemented with lazy deletion, the way e.g. Dijkstra's algorithm is
+ *  usually written on top of it. Every handle owns a slot with a version
+ *  number. Entries whose version does not match their slot are stale and
+ *  are skipped when they reach the top. Handles of the other queue are
+ *  invalidated by meld.
+ */
+template<class T>
+class StlAdapter
+{
+public:
+    using value_type  = T;
+    using handle_type = std::uint32_t;
+
+    auto insert(value_type const& value) -> handle_type
+    {
+        auto slot = handle_type();
+        if (freeSlots_.empty())
+        {
+            slot = static_cast<handle_type>(versions_.size());
+            versions_.push_back(0);
+        }
+        else
+        {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        queue_.push(Entry {value, slot, versions_[slot]});
+        ++size_;
+        return slot;
+    }
+
+    auto assign(std::vector<value_type> const& values) -> void
+    {
+        auto entries = std::vector<Entry>();
+        entries.reserve(values.size());
+        for (auto const& value : values)
+        {
+            auto const slot = static_cast<handle_type>(entries.size());
+            entries.push_back(Entry {value, slot, 0});
+        }
+        queue_ = Queue(EntryGreater(), std::move(entries));
+        versions_.assign(values.size(), 0);
+        freeSlots_.clear();
+        size_ = values.size();
+    }
+
+    auto insert_range(
+        std::span<value_type const> const values,
+        std::span<handle_type> const handles
+    ) -> void
+    {
+        for (auto i = std::size_t(0); i < values.size(); ++i)
+        {
+            handles[i] = this->insert(values[i]);
+        }
+    }
+
+    auto find_min() -> value_type const&
+    {
+        return queue_.top().value_;
+    }
+
+    auto delete_min() -> void
+    {
+        this->release(queue_.top().slot_);
+        queue_.pop();
+        this->prune();
+    }
+
+    auto decrease_key(handle_type const handle, value_type const& value)
+        -> void
+    {
+        ++versions_[handle];
+        queue_.push(Entry {value, handle, versions_[handle]});
+        this->prune();
+    }
+
+    auto increase_key(handle_type const handle, value_type const& value)
+        -> void
+    {
+        this->decrease_key(handle, value);
+    }
+
+    auto erase(handle_type const handle) -> void
+    {
+        this->release(handle);
+        this->prune();
+    }
+
+    auto meld(StlAdapter& other) -> void
+    {
+        for (auto const& entry : other.queue_.container())
+        {
+            if (other.is_live(entry))
+            {
+                this->insert(entry.value_);
+            }
+        }
+        other = StlAdapter();
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+        return size_;
+    }
+
+private:
+    struct Entry
+    {
+        value_type value_;
+        handle_type slot_;
+        std::uint32_t version_;
+    };
+
+    struct EntryGreater
+    {
+        auto operator()(Entry const& l, Entry const& r) const -> bool
+        {
+            return r.value_ < l.value_;
+        }
+    };
+
+    class Queue : public std::priority_queue<
+                      Entry,
+                      std::vector<Entry>,
+                      EntryGreater>
+    {
+    public:
+        using std::priority_queue<
+            Entry,
+            std::vector<Entry>,
+            EntryGreater>::priority_queue;
+
+        auto container() const -> std::vector<Entry> const&
+        {
+            return this->c;
+        }
+    };
+
+private:
+    [[nodiscard]] auto is_live(Entry const& entry) const -> bool
+    {
+        return versions_[entry.slot_] == entry.version_;
+    }
+
+    auto release(handle_type const slot) -> void
+    {
+        ++versions_[slot];
+        freeSlots_.push_back(slot);
+        --size_;
+    }
+
+    auto prune() -> void
+    {
+        while (not queue_.empty() && not this->is_live(queue_.top()))
+        {
+            queue_.pop();
+        }
+    }
+
+private:
+    Queue queue_;
+    std::vector<std::uint32_t> versions_;
+    std::vector<handle_type> freeSlots_;
+    std::size_t size_ {0};
+};
+
+/**
+ *  \brief Benchmarked heaps parametrized by the element type.
+ */
+template<class T>
+using PairingTwoPass = PairingAdapter<PairingHeap<T>>;
+
+template<class T>
+using PairingFifo = PairingAdapter<
+    PairingHeap<T, details::less<T>, merge_mode::FifoQueue>>;
+
+template<class T>
+using PairingMultipass = PairingAdapter<
+    PairingHeap<T, details::less<T>, merge_mode::Hierarchical>>;
+
+template<class T>
+using PairingAux = PairingAdapter<
+    PairingHeap<T, details::less<T>, merge_mode::AuxiliaryTwoPass>>;
+
+template<class T>
+using PairingPool = PairingAdapter<PairingHeap<
+    T, details::less<T>, merge_mode::TwoPass, PoolAllocator<T>>>;
+
+template<class T>
+using PairingIntrusive = IntrusiveAdapter<T, merge_mode::TwoPass>;
+
+template<class T>
+using Brodal = BrodalAdapter<brodal_queue<T>>;
+
+template<class T>
+using BrodalRelaxed = BrodalAdapter<
+    brodal_queue<T, std::less<T>, std::allocator<T>, brodal_policy::relaxed>>;
+
+template<class T>
+using Stl = StlAdapter<T>;
+} // namespace idril::bench
+
+#endif
@@ -0,0 +1,918 @@
+/**
+ *  Heap benchmark.
+ *
+ *  Runs the same operation mixes over PairingHeap, brodal_queue and
+ *  std::priority_queue for several element types, sizes and key
+ *  distributions. Reports throughput, percentiles of ns/op and peak RSS.
+ *
+ *  Usage: idril_heap_benchmark [options]
+ *    --min-size N      smallest heap size (default 1e3)
+ *    --max-size N      largest heap size, sizes grow by 10x (default 1e6)
+ *    --heap a,b        heaps to run (default all)
+ *    --type a,b        element types to run (default all)
+ *    --dist a,b        key distributions to run (default all)
+ *    --workload a,b    workloads to run (default all)
+ *    --reps N          repetitions of each run (default 1)
+ *    --seed N          seed of the random generator (default 42)
+ *    --csv             print results as CSV
+ *    --list            print available heaps, types, ... and exit
+ *
+ *  Latency mode: idril_heap_benchmark --latency [options]
+ *    Times every single operation of a random operation mix with the cycle
+ *    counter and prints p50/p99/p99.9/max of each operation type. Accepts
+ *    --min-size, --max-size, --heap, --dist, --reps, --seed, --csv and
+ *    --ops N           number of operations per run (default 1e6)
+ */
+
+#include "common.hpp"
+#include "heap_adapters.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace idril::bench
+{
+/**
+ *  \brief Parameters of a single run.
+ */
+struct RunConfig
+{
+    std::uint64_t size_;
+    KeyDistribution dist_;
+    std::uint64_t seed_;
+};
+
+/**
+ *  \brief Workload that builds a heap from scratch.
+ */
+template<class Adapter, class T>
+auto workload_insert(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto heap = Adapter();
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        heap.insert(traits::make(keys[i]));
+    });
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Workload that builds a heap from a range at once.
+ */
+template<class Adapter, class T>
+auto workload_build(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto values     = std::vector<T>();
+    values.reserve(keys.size());
+    for (auto const key : keys)
+    {
+        values.push_back(traits::make(key));
+    }
+
+    auto heap = Adapter();
+    rec.run_bulk(cfg.size_, [&]
+    {
+        heap.assign(values);
+    });
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Workload that inserts elements in batches keeping their handles.
+ */
+template<class Adapter, class T>
+auto workload_insert_batch(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto constexpr BatchSize = std::uint64_t(1'000);
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto values     = std::vector<T>();
+    values.reserve(keys.size());
+    for (auto const key : keys)
+    {
+        values.push_back(traits::make(key));
+    }
+
+    auto heap    = Adapter();
+    auto handles = std::vector<typename Adapter::handle_type>(cfg.size_);
+    for (auto first = std::uint64_t(0); first < cfg.size_; first += BatchSize)
+    {
+        auto const count = std::min(BatchSize, cfg.size_ - first);
+        rec.run_bulk(count, [&]
+        {
+            heap.insert_range(
+                std::span<T const>(values).subspan(first, count),
+                std::span(handles).subspan(first, count)
+            );
+        });
+    }
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Workload that empties a heap using delete_min.
+ */
+template<class Adapter, class T>
+auto workload_delete_min(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto heap = Adapter();
+    for (auto const key : keys)
+    {
+        heap.insert(traits::make(key));
+    }
+
+    auto sum = std::uint64_t(0);
+    rec.run(cfg.size_, [&](auto)
+    {
+        sum += traits::key(heap.find_min());
+        heap.delete_min();
+    });
+    do_not_optimize(sum);
+}
+
+/**
+ *  \brief The classic hold model of discrete event simulation.
+ *
+ *  Each operation removes the minimum and inserts new element with key
+ *  greater than the removed one.
+ */
+template<class Adapter, class T>
+auto workload_hold(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto rng = std::mt19937_64(cfg.seed_ + 1);
+    auto increments = std::vector<std::uint64_t>(cfg.size_);
+    for (auto& inc : increments)
+    {
+        inc = rng() % (1u << 20);
+    }
+
+    auto heap = Adapter();
+    for (auto const key : keys)
+    {
+        heap.insert(traits::make(key));
+    }
+
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        auto const min = traits::key(heap.find_min());
+        heap.delete_min();
+        heap.insert(traits::make(std::min(MaxKey, min + increments[i])));
+    });
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Workload that decreases keys of random elements.
+ */
+template<class Adapter, class T>
+auto workload_decrease_key(RunConfig const& cfg, BatchRecorder& rec)
+    -> void
+{
+    using traits = ElementTraits<T>;
+    auto keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto rng  = std::mt19937_64(cfg.seed_ + 1);
+    auto targets = std::vector<std::uint64_t>(cfg.size_);
+    for (auto& target : targets)
+    {
+        target = rng() % cfg.size_;
+    }
+
+    auto heap    = Adapter();
+    auto handles = std::vector<typename Adapter::handle_type>();
+    handles.reserve(cfg.size_);
+    for (auto const key : keys)
+    {
+        handles.push_back(heap.insert(traits::make(key)));
+    }
+
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        auto const target = targets[i];
+        keys[target] -= std::min(keys[target], (keys[target] >> 4) + 1);
+        heap.decrease_key(handles[target], traits::make(keys[target]));
+    });
+    do_not_optimize(heap.find_min());
+}
+
+/**
+ *  \brief Workload that increases keys of random elements.
+ */
+template<class Adapter, class T>
+auto workload_increase_key(RunConfig const& cfg, BatchRecorder& rec)
+    -> void
+{
+    using traits = ElementTraits<T>;
+    auto keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto rng  = std::mt19937_64(cfg.seed_ + 1);
+    auto targets = std::vector<std::uint64_t>(cfg.size_);
+    for (auto& target : targets)
+    {
+        target = rng() % cfg.size_;
+    }
+
+    auto heap    = Adapter();
+    auto handles = std::vector<typename Adapter::handle_type>();
+    handles.reserve(cfg.size_);
+    for (auto const key : keys)
+    {
+        handles.push_back(heap.insert(traits::make(key)));
+    }
+
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        auto const target = targets[i];
+        keys[target] += std::min(
+            MaxKey - keys[target], (keys[target] >> 4) + 1
+        );
+        heap.increase_key(handles[target], traits::make(keys[target]));
+    });
+    do_not_optimize(heap.find_min());
+}
+
+/**
+ *  \brief Workload that erases all elements in random order.
+ */
+template<class Adapter, class T>
+auto workload_erase(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto order = std::vector<std::uint64_t>(cfg.size_);
+    std::iota(order.begin(), order.end(), std::uint64_t(0));
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(cfg.seed_ + 1));
+
+    auto heap    = Adapter();
+    auto handles = std::vector<typename Adapter::handle_type>();
+    handles.reserve(cfg.size_);
+    for (auto const key : keys)
+    {
+        handles.push_back(heap.insert(traits::make(key)));
+    }
+
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        heap.erase(handles[order[i]]);
+    });
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Workload that melds many small heaps into a single one.
+ */
+template<class Adapter, class T>
+auto workload_meld(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    using traits = ElementTraits<T>;
+    auto constexpr SmallSize = std::uint64_t(64);
+    auto const keys  = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto const count = std::max<std::uint64_t>(1, cfg.size_ / SmallSize);
+    auto smalls = std::vector<Adapter>(count);
+    for (auto i = std::uint64_t(0); i < keys.size(); ++i)
+    {
+        smalls[i % count].insert(traits::make(keys[i]));
+    }
+
+    auto heap = Adapter();
+    rec.run(count, [&](auto const i)
+    {
+        heap.meld(smalls[i]);
+    });
+    do_not_optimize(heap.size());
+}
+
+using workload_fn = void (*)(RunConfig const&, BatchRecorder&);
+
+/**
+ *  \brief Named workload.
+ */
+struct Workload
+{
+    std::string_view name_;
+    workload_fn run_;
+};
+
+template<class Adapter, class T>
+auto workloads() -> std::vector<Workload>
+{
+    return {
+        {"insert", &workload_insert<Adapter, T>},
+        {"build", &workload_build<Adapter, T>},
+        {"insert_batch", &workload_insert_batch<Adapter, T>},
+        {"delete_min", &workload_delete_min<Adapter, T>},
+        {"hold", &workload_hold<Adapter, T>},
+        {"decrease_key", &workload_decrease_key<Adapter, T>},
+        {"increase_key", &workload_increase_key<Adapter, T>},
+        {"erase", &workload_erase<Adapter, T>},
+        {"meld", &workload_meld<Adapter, T>},
+    };
+}
+
+/**
+ *  \brief Formats and prints results.
+ */
+class Reporter
+{
+public:
+    explicit Reporter(bool const csv) : csv_(csv)
+    {
+    }
+
+    auto header() const -> void
+    {
+        if (csv_)
+        {
+            std::printf(
+                "heap,type,dist,workload,n,ops,ops_per_sec,"
+                "p50_ns,p90_ns,p99_ns,peak_rss_mib\n"
+            );
+        }
+        else
+        {
+            std::printf(
+                "%-18s %-9s %-11s %-13s %11s %14s %9s %9s %9s %10s\n",
+                "heap", "type", "dist", "workload", "n", "ops/s",
+                "p50 ns", "p90 ns", "p99 ns", "RSS MiB"
+            );
+        }
+    }
+
+    auto row(
+        std::string_view const heap,
+        std::string_view const type,
+        std::string_view const dist,
+        std::string_view const workload,
+        std::uint64_t const n,
+        RunStats const& stats,
+        std::uint64_t const rss
+    ) const -> void
+    {
+        auto const* const format
+            = csv_ ? "%.*s,%.*s,%.*s,%.*s,%llu,%llu,%.0f,%.2f,%.2f,%.2f,%.1f\n"
+                   : "%-18.*s %-9.*s %-11.*s %-13.*s %11llu %14.0f"
+                     " %9.2f %9.2f %9.2f %10.1f\n";
+        if (csv_)
+        {
+            std::printf(
+                format,
+                static_cast<int>(heap.size()), heap.data(),
+                static_cast<int>(type.size()), type.data(),
+                static_cast<int>(dist.size()), dist.data(),
+                static_cast<int>(workload.size()), workload.data(),
+                static_cast<unsigned long long>(n),
+                static_cast<unsigned long long>(stats.ops_),
+                stats.ops_per_sec(), stats.p50_, stats.p90_, stats.p99_,
+                to_mib(rss)
+            );
+        }
+        else
+        {
+            std::printf(
+                format,
+                static_cast<int>(heap.size()), heap.data(),
+                static_cast<int>(type.size()), type.data(),
+                static_cast<int>(dist.size()), dist.data(),
+                static_cast<int>(workload.size()), workload.data(),
+                static_cast<unsigned long long>(n),
+                stats.ops_per_sec(), stats.p50_, stats.p90_, stats.p99_,
+                to_mib(rss)
+            );
+        }
+        std::fflush(stdout);
+    }
+
+private:
+    bool csv_;
+};
+
+/**
+ *  \brief Selection of what should be run.
+ */
+struct Selection
+{
+    std::vector<std::string> heaps_;
+    std::vector<std::string> types_;
+    std::vector<std::string> dists_;
+    std::vector<std::string> workloads_;
+    std::uint64_t minSize_;
+    std::uint64_t maxSize_;
+    std::uint64_t reps_;
+    std::uint64_t seed_;
+};
+
+template<template<class> class Adapter, class T>
+auto run_type(
+    std::string_view const heapName,
+    Selection const& sel,
+    Reporter const& reporter
+) -> void
+{
+    using traits = ElementTraits<T>;
+    if (not is_selected(sel.types_, traits::Name))
+    {
+        return;
+    }
+
+    for (auto const& workload : workloads<Adapter<T>, T>())
+    {
+        if (not is_selected(sel.workloads_, workload.name_))
+        {
+            continue;
+        }
+
+        for (auto const dist : KeyDistributions)
+        {
+            if (not is_selected(sel.dists_, to_string(dist)))
+            {
+                continue;
+            }
+
+            for (auto n = sel.minSize_; n <= sel.maxSize_; n *= 10)
+            {
+                auto recorder = BatchRecorder();
+                reset_peak_rss();
+                for (auto rep = std::uint64_t(0); rep < sel.reps_; ++rep)
+                {
+                    auto const cfg = RunConfig {n, dist, sel.seed_};
+                    workload.run_(cfg, recorder);
+                }
+                reporter.row(
+                    heapName,
+                    traits::Name,
+                    to_string(dist),
+                    workload.name_,
+                    n,
+                    recorder.stats(),
+                    peak_rss()
+                );
+            }
+        }
+    }
+}
+
+template<template<class> class Adapter>
+auto run_heap(
+    std::string_view const heapName,
+    Selection const& sel,
+    Reporter const& reporter
+) -> void
+{
+    if (not is_selected(sel.heaps_, heapName))
+    {
+        return;
+    }
+
+    run_type<Adapter, std::uint32_t>(heapName, sel, reporter);
+    run_type<Adapter, std::uint64_t>(heapName, sel, reporter);
+    run_type<Adapter, Record>(heapName, sel, reporter);
+}
+
+// Latency mode:
+
+/**
+ *  \brief Element of the latency workload, id identifies its handle.
+ */
+struct TaggedKey
+{
+    std::uint64_t key_;
+    std::uint64_t id_;
+
+    friend auto operator<(TaggedKey const& l, TaggedKey const& r) -> bool
+    {
+        return l.key_ < r.key_;
+    }
+};
+
+/**
+ *  \brief Id of elements that do not have a tracked handle.
+ */
+inline constexpr auto UntrackedId = std::numeric_limits<std::uint64_t>::max();
+
+/**
+ *  \brief Operations timed by the latency mode.
+ */
+enum class LatencyOp
+{
+    FindMin,
+    Insert,
+    DeleteMin,
+    DecreaseKey,
+    Erase,
+    Meld
+};
+
+inline constexpr auto LatencyOpCount = std::size_t(6);
+
+inline constexpr auto LatencyOpNames = std::array<std::string_view, 6> {
+    "find_min", "insert", "delete_min", "decrease_key", "erase", "meld"
+};
+
+using latency_hists = std::array<LatencyHistogram, LatencyOpCount>;
+
+/**
+ *  \brief Handles of live elements that can be picked uniformly at random.
+ */
+template<class Handle>
+class LiveHandles
+{
+public:
+    auto add(std::uint64_t const id, Handle const handle, std::uint64_t key)
+        -> void
+    {
+        if (id >= handles_.size())
+        {
+            handles_.resize(id + 1);
+            positions_.resize(id + 1);
+            keys_.resize(id + 1);
+        }
+        handles_[id]   = handle;
+        keys_[id]      = key;
+        positions_[id] = live_.size();
+        live_.push_back(id);
+    }
+
+    auto remove(std::uint64_t const id) -> void
+    {
+        auto const pos  = positions_[id];
+        auto const last = live_.back();
+        live_[pos]        = last;
+        positions_[last]  = pos;
+        live_.pop_back();
+        handles_[id].reset();
+    }
+
+    [[nodiscard]] auto empty() const -> bool
+    {
+        return live_.empty();
+    }
+
+    template<class Rng>
+    [[nodiscard]] auto pick(Rng& rng) const -> std::uint64_t
+    {
+        return live_[rng() % live_.size()];
+    }
+
+    [[nodiscard]] auto handle(std::uint64_t const id) const -> Handle
+    {
+        return *handles_[id];
+    }
+
+    [[nodiscard]] auto key(std::uint64_t const id) -> std::uint64_t&
+    {
+        return keys_[id];
+    }
+
+private:
+    std::vector<std::optional<Handle>> handles_;
+    std::vector<std::uint64_t> positions_;
+    std::vector<std::uint64_t> keys_;
+    std::vector<std::uint64_t> live_;
+};
+
+/**
+ *  \brief Calls \p f and records its duration into \p hist
+ */
+template<class F>
+auto timed(LatencyHistogram& hist, F f) -> decltype(f())
+{
+    auto const start = read_cycles();
+    if constexpr (std::is_void_v<decltype(f())>)
+    {
+        f();
+        hist.record(read_cycles() - start);
+    }
+    else
+    {
+        auto result = f();
+        hist.record(read_cycles() - start);
+        return result;
+    }
+}
+
+/**
+ *  \brief Runs a random operation mix on a heap of size \p n and times
+ *  every single operation
+ *
+ *  The mix is 40% insert, 30% find_min + delete_min, 20% decrease_key,
+ *  5% erase and 5% meld with a small heap.
+ */
+template<class Adapter>
+auto run_latency(
+    std::uint64_t const n,
+    std::uint64_t const ops,
+    KeyDistribution const dist,
+    std::uint64_t const seed,
+    latency_hists& hists
+) -> void
+{
+    auto constexpr MeldSize = std::uint64_t(8);
+    auto const keys = generate_keys(dist, n + ops, seed);
+    auto rng        = std::mt19937_64(seed + 1);
+    auto heap       = Adapter();
+    auto live       = LiveHandles<typename Adapter::handle_type>();
+    auto nextKey    = std::uint64_t(0);
+    auto nextId     = std::uint64_t(0);
+    auto hist = [&hists](LatencyOp const op) -> LatencyHistogram&
+    {
+        return hists[static_cast<std::size_t>(op)];
+    };
+
+    for (; nextKey < n; ++nextKey, ++nextId)
+    {
+        auto const key = keys[nextKey];
+        live.add(nextId, heap.insert(TaggedKey {key, nextId}), key);
+    }
+
+    for (auto i = std::uint64_t(0); i < ops; ++i)
+    {
+        auto const roll = heap.size() == 0 ? 0 : rng() % 100;
+        if (roll < 40)
+        {
+            auto const key    = keys[nextKey++ % keys.size()];
+            auto const id     = nextId++;
+            auto const handle = timed(hist(LatencyOp::Insert), [&]
+            {
+                return heap.insert(TaggedKey {key, id});
+            });
+            live.add(id, handle, key);
+        }
+        else if (roll < 70)
+        {
+            auto const min = timed(hist(LatencyOp::FindMin), [&]
+            {
+                return heap.find_min();
+            });
+            timed(hist(LatencyOp::DeleteMin), [&]
+            {
+                heap.delete_min();
+            });
+            if (min.id_ != UntrackedId)
+            {
+                live.remove(min.id_);
+            }
+        }
+        else if (roll < 90)
+        {
+            if (live.empty())
+            {
+                continue;
+            }
+            auto const id = live.pick(rng);
+            auto& key     = live.key(id);
+            key          -= std::min(key, (key >> 4) + 1);
+            auto const newValue = TaggedKey {key, id};
+            timed(hist(LatencyOp::DecreaseKey), [&]
+            {
+                heap.decrease_key(live.handle(id), newValue);
+            });
+        }
+        else if (roll < 95)
+        {
+            if (live.empty())
+            {
+                continue;
+            }
+            auto const id = live.pick(rng);
+            timed(hist(LatencyOp::Erase), [&]
+            {
+                heap.erase(live.handle(id));
+            });
+            live.remove(id);
+        }
+        else
+        {
+            auto other = Adapter();
+            for (auto j = std::uint64_t(0); j < MeldSize; ++j)
+            {
+                other.insert(
+                    TaggedKey {keys[nextKey++ % keys.size()], UntrackedId}
+                );
+            }
+            timed(hist(LatencyOp::Meld), [&]
+            {
+                heap.meld(other);
+            });
+        }
+    }
+    do_not_optimize(heap.size());
+}
+
+/**
+ *  \brief Formats and prints latency histograms.
+ */
+class LatencyReporter
+{
+public:
+    explicit LatencyReporter(bool const csv) : csv_(csv)
+    {
+    }
+
+    auto header() const -> void
+    {
+        if (csv_)
+        {
+            std::printf(
+                "heap,dist,n,op,count,mean,p50,p99,p99_9,max\n"
+            );
+        }
+        else
+        {
+            std::printf("all latencies are in cycles of read_cycles()\n");
+            std::printf(
+                "%-18s %-11s %11s %-13s %10s %10s %9s %9s %9s %11s\n",
+                "heap", "dist", "n", "op", "count", "mean", "p50", "p99",
+                "p99.9", "max"
+            );
+        }
+    }
+
+    auto row(
+        std::string_view const heap,
+        std::string_view const dist,
+        std::uint64_t const n,
+        std::string_view const op,
+        LatencyHistogram const& hist
+    ) const -> void
+    {
+        auto const* const format
+            = csv_ ? "%.*s,%.*s,%llu,%.*s,%llu,%.1f,%llu,%llu,%llu,%llu\n"
+                   : "%-18.*s %-11.*s %11llu %-13.*s %10llu %10.1f %9llu"
+                     " %9llu %9llu %11llu\n";
+        std::printf(
+            format,
+            static_cast<int>(heap.size()), heap.data(),
+            static_cast<int>(dist.size()), dist.data(),
+            static_cast<unsigned long long>(n),
+            static_cast<int>(op.size()), op.data(),
+            static_cast<unsigned long long>(hist.count()),
+            hist.mean(),
+            static_cast<unsigned long long>(hist.percentile(0.50)),
+            static_cast<unsigned long long>(hist.percentile(0.99)),
+            static_cast<unsigned long long>(hist.percentile(0.999)),
+            static_cast<unsigned long long>(hist.max())
+        );
+        std::fflush(stdout);
+    }
+
+private:
+    bool csv_;
+};
+
+template<template<class> class Adapter>
+auto run_latency_heap(
+    std::string_view const heapName,
+    Selection const& sel,
+    std::uint64_t const ops,
+    LatencyReporter const& reporter
+) -> void
+{
+    if (not is_selected(sel.heaps_, heapName))
+    {
+        return;
+    }
+
+    for (auto const dist : KeyDistributions)
+    {
+        if (not is_selected(sel.dists_, to_string(dist)))
+        {
+            continue;
+        }
+
+        for (auto n = sel.minSize_; n <= sel.maxSize_; n *= 10)
+        {
+            auto hists = latency_hists();
+            for (auto rep = std::uint64_t(0); rep < sel.reps_; ++rep)
+            {
+                run_latency<Adapter<TaggedKey>>(n, ops, dist, sel.seed_, hists);
+            }
+            for (auto op = std::size_t(0); op < LatencyOpCount; ++op)
+            {
+                reporter.row(
+                    heapName, to_string(dist), n, LatencyOpNames[op], hists[op]
+                );
+            }
+        }
+    }
+}
+
+/**
+ *  \brief Measures the overhead of the timer itself
+ */
+auto timer_overhead() -> LatencyHistogram
+{
+    auto hist = LatencyHistogram();
+    for (auto i = 0; i < 100'000; ++i)
+    {
+        timed(hist, [] {});
+    }
+    return hist;
+}
+
+auto run_latency_mode(
+    Selection const& sel, std::uint64_t const ops, bool const csv
+) -> void
+{
+    auto const reporter = LatencyReporter(csv);
+    reporter.header();
+    reporter.row("-", "-", 0, "timer", timer_overhead());
+    run_latency_heap<PairingTwoPass>("pairing", sel, ops, reporter);
+    run_latency_heap<PairingFifo>("pairing-fifo", sel, ops, reporter);
+    run_latency_heap<PairingMultipass>("pairing-multipass", sel, ops, reporter);
+    run_latency_heap<PairingAux>("pairing-aux", sel, ops, reporter);
+    run_latency_heap<PairingPool>("pairing-pool", sel, ops, reporter);
+    run_latency_heap<PairingIntrusive>(
+        "pairing-intrusive", sel, ops, reporter
+    );
+    run_latency_heap<Brodal>("brodal", sel, ops, reporter);
+    run_latency_heap<BrodalRelaxed>("brodal-relaxed", sel, ops, reporter);
+    run_latency_heap<Stl>("stl", sel, ops, reporter);
+}
+
+auto print_list() -> void
+{
+    std::printf(
+        "heaps:      pairing pairing-fifo pairing-multipass pairing-aux"
+        " pairing-pool\n            pairing-intrusive brodal brodal-relaxed"
+        " stl\n"
+    );
+    std::printf("types:      u32 u64 record64\n");
+    std::printf("dists:     ");
+    for (auto const dist : KeyDistributions)
+    {
+        auto const name = to_string(dist);
+        std::printf(" %.*s", static_cast<int>(name.size()), name.data());
+    }
+    std::printf("\nworkloads: ");
+    for (auto const& workload : workloads<Stl<std::uint32_t>, std::uint32_t>())
+    {
+        std::printf(
+            " %.*s",
+            static_cast<int>(workload.name_.size()),
+            workload.name_.data()
+        );
+    }
+    std::printf("\n");
+}
+} // namespace idril::bench
+
+auto main(int argc, char** argv) -> int
+{
+    using namespace idril::bench;
+
+    auto const cmd = CommandLine(argc, argv);
+    if (cmd.has("--list"))
+    {
+        print_list();
+        return 0;
+    }
+
+    auto sel       = Selection();
+    sel.heaps_     = cmd.list("--heap");
+    sel.types_     = cmd.list("--type");
+    sel.dists_     = cmd.list("--dist");
+    sel.workloads_ = cmd.list("--workload");
+    sel.minSize_   = std::max<std::uint64_t>(1, cmd.number("--min-size", 1e3));
+    sel.maxSize_   = cmd.number("--max-size", 1e6);
+    sel.reps_      = std::max<std::uint64_t>(1, cmd.number("--reps", 1));
+    sel.seed_      = cmd.number("--seed", 42);
+
+    if (cmd.has("--latency"))
+    {
+        auto const ops = cmd.number("--ops", 1e6);
+        run_latency_mode(sel, ops, cmd.has("--csv"));
+        return 0;
+    }
+
+    auto const reporter = Reporter(cmd.has("--csv"));
+    reporter.header();
+
+    run_heap<PairingTwoPass>("pairing", sel, reporter);
+    run_heap<PairingFifo>("pairing-fifo", sel, reporter);
+    run_heap<PairingMultipass>("pairing-multipass", sel, reporter);
+    run_heap<PairingAux>("pairing-aux", sel, reporter);
+    run_heap<PairingPool>("pairing-pool", sel, reporter);
+    run_heap<PairingIntrusive>("pairing-intrusive", sel, reporter);
+    run_heap<Brodal>("brodal", sel, reporter);
+    run_heap<BrodalRelaxed>("brodal-relaxed", sel, reporter);
+    run_heap<Stl>("stl", sel, reporter);
+
+    return 0;
+}
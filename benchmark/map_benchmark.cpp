@@ -0,0 +1,384 @@
+/**
+ *  Ordered map benchmark.
+ *
+ *  Runs the same operation mixes over Bst (red-black and AVL), BTree and
+ *  std::map with 64-bit keys and values for several sizes and key
+ *  distributions. Reports throughput, percentiles of ns/op and peak RSS.
+ *
+ *  Usage: idril_map_benchmark [options]
+ *    --min-size N      smallest map size (default 1e3)
+ *    --max-size N      largest map size, sizes grow by 10x (default 1e6)
+ *    --map a,b         maps to run (default all)
+ *    --dist a,b        key distributions to run (default all)
+ *    --workload a,b    workloads to run (default all)
+ *    --reps N          repetitions of each run (default 1)
+ *    --seed N          seed of the random generator (default 42)
+ *    --csv             print results as CSV
+ *    --list            print available maps, workloads, ... and exit
+ */
+
+#include "bst.hpp"
+#include "btree.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace idril::bench
+{
+using key_t = std::uint64_t;
+
+using BstRedBlack = Bst<
+    key_t, key_t, details::less<key_t>,
+    std::allocator<std::pair<key_t const, key_t>>, balance_mode::RedBlack>;
+using BstAvl = Bst<
+    key_t, key_t, details::less<key_t>,
+    std::allocator<std::pair<key_t const, key_t>>, balance_mode::Avl>;
+using BTreeMap = BTree<key_t, key_t>;
+using StlMap = std::map<key_t, key_t>;
+
+/**
+ *  \brief Parameters of a single run.
+ */
+struct RunConfig
+{
+    std::uint64_t size_;
+    KeyDistribution dist_;
+    std::uint64_t seed_;
+};
+
+/**
+ *  \brief Returns \p keys in random order
+ */
+inline auto shuffled(std::vector<key_t> keys, std::uint64_t const seed)
+    -> std::vector<key_t>
+{
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed));
+    return keys;
+}
+
+/**
+ *  \brief Workload that builds a map from scratch.
+ */
+template<class Map>
+auto workload_insert(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto map = Map();
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        map.insert({keys[i], i});
+    });
+    do_not_optimize(map.size());
+}
+
+/**
+ *  \brief Workload that looks up every key in random order.
+ */
+template<class Map>
+auto workload_find(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto map = Map();
+    for (auto i = std::uint64_t(0); i < keys.size(); ++i)
+    {
+        map.insert({keys[i], i});
+    }
+
+    auto const order = shuffled(keys, cfg.seed_ + 1);
+    auto hits = std::uint64_t(0);
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        hits += static_cast<std::uint64_t>(map.find(order[i]) != map.end());
+    });
+    do_not_optimize(hits);
+}
+
+/**
+ *  \brief Workload that looks up keys that are not in the map.
+ */
+template<class Map>
+auto workload_find_miss(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    // Map holds even keys and odd keys are looked up so that misses end
+    // all over the tree.
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto map = Map();
+    for (auto i = std::uint64_t(0); i < keys.size(); ++i)
+    {
+        map.insert({2 * keys[i], i});
+    }
+
+    auto order = shuffled(keys, cfg.seed_ + 1);
+    for (auto& key : order)
+    {
+        key = 2 * key + 1;
+    }
+    auto hits = std::uint64_t(0);
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        hits += static_cast<std::uint64_t>(map.find(order[i]) != map.end());
+    });
+    do_not_optimize(hits);
+}
+
+/**
+ *  \brief Workload that erases all keys in random order.
+ */
+template<class Map>
+auto workload_erase(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto map = Map();
+    for (auto i = std::uint64_t(0); i < keys.size(); ++i)
+    {
+        map.insert({keys[i], i});
+    }
+
+    auto const order = shuffled(keys, cfg.seed_ + 1);
+    rec.run(cfg.size_, [&](auto const i)
+    {
+        map.erase(order[i]);
+    });
+    do_not_optimize(map.size());
+}
+
+/**
+ *  \brief Workload that iterates over the whole map.
+ */
+template<class Map>
+auto workload_iterate(RunConfig const& cfg, BatchRecorder& rec) -> void
+{
+    auto const keys = generate_keys(cfg.dist_, cfg.size_, cfg.seed_);
+    auto map = Map();
+    for (auto i = std::uint64_t(0); i < keys.size(); ++i)
+    {
+        map.insert({keys[i], i});
+    }
+
+    auto sum = std::uint64_t(0);
+    rec.run_bulk(map.size(), [&]
+    {
+        for (auto const& [key, value] : map)
+        {
+            sum += key ^ value;
+        }
+    });
+    do_not_optimize(sum);
+}
+
+using workload_fn = void (*)(RunConfig const&, BatchRecorder&);
+
+/**
+ *  \brief Named workload.
+ */
+struct Workload
+{
+    std::string_view name_;
+    workload_fn run_;
+};
+
+template<class Map>
+auto workloads() -> std::vector<Workload>
+{
+    return {
+        {"insert", &workload_insert<Map>},
+        {"find", &workload_find<Map>},
+        {"find_miss", &workload_find_miss<Map>},
+        {"erase", &workload_erase<Map>},
+        {"iterate", &workload_iterate<Map>},
+    };
+}
+
+/**
+ *  \brief Formats and prints results.
+ */
+class Reporter
+{
+public:
+    explicit Reporter(bool const csv) : csv_(csv)
+    {
+    }
+
+    auto header() const -> void
+    {
+        if (csv_)
+        {
+            std::printf(
+                "map,dist,workload,n,ops,ops_per_sec,"
+                "p50_ns,p90_ns,p99_ns,peak_rss_mib\n"
+            );
+        }
+        else
+        {
+            std::printf(
+                "%-9s %-11s %-10s %11s %14s %9s %9s %9s %10s\n",
+                "map", "dist", "workload", "n", "ops/s",
+                "p50 ns", "p90 ns", "p99 ns", "RSS MiB"
+            );
+        }
+    }
+
+    auto row(
+        std::string_view const map,
+        std::string_view const dist,
+        std::string_view const workload,
+        std::uint64_t const n,
+        RunStats const& stats,
+        std::uint64_t const rss
+    ) const -> void
+    {
+        if (csv_)
+        {
+            std::printf(
+                "%.*s,%.*s,%.*s,%llu,%llu,%.0f,%.2f,%.2f,%.2f,%.1f\n",
+                static_cast<int>(map.size()), map.data(),
+                static_cast<int>(dist.size()), dist.data(),
+                static_cast<int>(workload.size()), workload.data(),
+                static_cast<unsigned long long>(n),
+                static_cast<unsigned long long>(stats.ops_),
+                stats.ops_per_sec(), stats.p50_, stats.p90_, stats.p99_,
+                to_mib(rss)
+            );
+        }
+        else
+        {
+            std::printf(
+                "%-9.*s %-11.*s %-10.*s %11llu %14.0f %9.2f %9.2f %9.2f"
+                " %10.1f\n",
+                static_cast<int>(map.size()), map.data(),
+                static_cast<int>(dist.size()), dist.data(),
+                static_cast<int>(workload.size()), workload.data(),
+                static_cast<unsigned long long>(n),
+                stats.ops_per_sec(), stats.p50_, stats.p90_, stats.p99_,
+                to_mib(rss)
+            );
+        }
+        std::fflush(stdout);
+    }
+
+private:
+    bool csv_;
+};
+
+/**
+ *  \brief Selection of what should be run.
+ */
+struct Selection
+{
+    std::vector<std::string> maps_;
+    std::vector<std::string> dists_;
+    std::vector<std::string> workloads_;
+    std::uint64_t minSize_;
+    std::uint64_t maxSize_;
+    std::uint64_t reps_;
+    std::uint64_t seed_;
+};
+
+template<class Map>
+auto run_map(
+    std::string_view const mapName,
+    Selection const& sel,
+    Reporter const& reporter
+) -> void
+{
+    if (not is_selected(sel.maps_, mapName))
+    {
+        return;
+    }
+
+    for (auto const& workload : workloads<Map>())
+    {
+        if (not is_selected(sel.workloads_, workload.name_))
+        {
+            continue;
+        }
+
+        for (auto const dist : KeyDistributions)
+        {
+            if (not is_selected(sel.dists_, to_string(dist)))
+            {
+                continue;
+            }
+
+            for (auto n = sel.minSize_; n <= sel.maxSize_; n *= 10)
+            {
+                auto recorder = BatchRecorder();
+                reset_peak_rss();
+                for (auto rep = std::uint64_t(0); rep < sel.reps_; ++rep)
+                {
+                    auto const cfg = RunConfig {n, dist, sel.seed_};
+                    workload.run_(cfg, recorder);
+                }
+                reporter.row(
+                    mapName,
+                    to_string(dist),
+                    workload.name_,
+                    n,
+                    recorder.stats(),
+                    peak_rss()
+                );
+            }
+        }
+    }
+}
+
+auto print_list() -> void
+{
+    std::printf("maps:       bst bst-avl btree stl\n");
+    std::printf("dists:     ");
+    for (auto const dist : KeyDistributions)
+    {
+        auto const name = to_string(dist);
+        std::printf(" %.*s", static_cast<int>(name.size()), name.data());
+    }
+    std::printf("\nworkloads: ");
+    for (auto const& workload : workloads<StlMap>())
+    {
+        std::printf(
+            " %.*s",
+            static_cast<int>(workload.name_.size()),
+            workload.name_.data()
+        );
+    }
+    std::printf("\n");
+}
+} // namespace idril::bench
+
+auto main(int argc, char** argv) -> int
+{
+    using namespace idril::bench;
+
+    auto const cmd = CommandLine(argc, argv);
+    if (cmd.has("--list"))
+    {
+        print_list();
+        return 0;
+    }
+
+    auto sel       = Selection();
+    sel.maps_      = cmd.list("--map");
+    sel.dists_     = cmd.list("--dist");
+    sel.workloads_ = cmd.list("--workload");
+    sel.minSize_   = std::max<std::uint64_t>(1, cmd.number("--min-size", 1e3));
+    sel.maxSize_   = cmd.number("--max-size", 1e6);
+    sel.reps_      = std::max<std::uint64_t>(1, cmd.number("--reps", 1));
+    sel.seed_      = cmd.number("--seed", 42);
+
+    auto const reporter = Reporter(cmd.has("--csv"));
+    reporter.header();
+
+    run_map<BstRedBlack>("bst", sel, reporter);
+    run_map<BstAvl>("bst-avl", sel, reporter);
+    run_map<BTreeMap>("btree", sel, reporter);
+    run_map<StlMap>("stl", sel, reporter);
+
+    return 0;
+}
@@ -2,18 +2,62 @@
 #define IDRIL_BRODAL_QUEUE_HPP
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <stdexcept>
 #include <string>
-#include <stack>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace idril
 {
+    /**
+     *  Block storage of the guide with inline fixed-size arrays.
+     *  Indices of a block share its id so that the whole block is
+     *  cancelled in O(1). Ids no index refers to are linked through
+     *  starts_. Ranks are bounded by log2 of the size so the capacity
+     *  is never exceeded.
+     */
+    class guide_blocks
+    {
+    public:
+        using index_t = std::uint8_t;
+
+        inline static constexpr auto NULL_BLOCK = std::numeric_limits<index_t>::max();
+
+    public:
+        guide_blocks ();
+
+        auto size       () const -> index_t;
+        auto block_of   (index_t const i) const -> index_t;
+        auto push_back  () -> void;
+        auto pop_back   () -> void;
+        auto make_block (index_t const i) -> void;
+        auto join_next  (index_t const i) -> void;
+        auto cancel     (index_t const i) -> void;
+
+    private:
+        auto set_id (index_t const i, index_t const id) -> void;
+
+    private:
+        inline static constexpr auto CAPACITY = std::size_t {64};
+        using ids_a = std::array<index_t, CAPACITY>;
+
+    private:
+        index_t size_   {0};
+        index_t freeId_ {0};
+        ids_a   ids_;
+        ids_a   starts_;
+        ids_a   refs_;
+    };
+
     /**
      *  Guide structure that is used to maintain invariants.
      */
@@ -21,16 +65,14 @@ namespace idril
     class guide
     {
     public:
-        using num_t    = std::uint8_t;
-        using index_t  = std::uint8_t;
-        using blocks_v = std::vector<std::shared_ptr<index_t>>;
+        using num_t   = std::uint8_t;
+        using index_t = std::uint8_t;
 
     public:
         guide (guide&& other) noexcept;
         guide (Reducer reducer, guide const& other);
         guide (Reducer reducer, guide&& other) noexcept;
         guide (Reducer reducer);
-        guide (Reducer reducer, blocks_v blocks);
 
         template<class R>
         guide (Reducer reducer, guide<R>&& other) noexcept;
@@ -43,6 +85,9 @@ namespace idril
         auto increase_domain () -> void;
         auto decrease_domain () -> void;
 
+        /// Drops all blocks. Valid only if no num is greater than 1.
+        auto reset () -> void;
+
         auto to_string () const -> std::string;
 
     private:
@@ -56,12 +101,12 @@ namespace idril
         auto is_valid_block_num     (num_t const num, index_t const i) -> bool;
 
     private:
-        inline static constexpr auto NULL_BLOCK = std::numeric_limits<index_t>::max();
+        inline static constexpr auto NULL_BLOCK = guide_blocks::NULL_BLOCK;
         template<class> friend class guide;
 
     private:
-        Reducer  reducer_;
-        blocks_v blocks_;
+        Reducer      reducer_;
+        guide_blocks blocks_;
     };
 
     template<class Reducer>
@@ -71,8 +116,28 @@ namespace idril
     template<class T, class Compare, class Allocator>
     class brodal_node;
 
+    /**
+     *  Rebalancing policies of brodal_queue.
+     */
+    namespace brodal_policy
+    {
+        /**
+         *  Restores all invariants after every operation so that every
+         *  operation keeps its worst-case bound.
+         */
+        struct worst_case {};
+
+        /**
+         *  Lets insert and decrease_key skip the violation and rank
+         *  checks and repairs them in one pass at the next delete_min
+         *  or meld or once 64 of them were skipped. Bounds become
+         *  amortized.
+         */
+        struct relaxed {};
+    }
+
     // Forward declarations of the queue:
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     class brodal_queue;
 
     /**
@@ -90,25 +155,104 @@ namespace idril
     };
 
     /**
-        Entry that wraps data inserted into the queue.
+        Entry that handles point to. It follows the data when they
+        are moved to another node.
      */
     template<class T, class Compare, class Allocator>
     class brodal_entry
     {
     public:
-        template<class... Args>
-        brodal_entry   (Args&&... args);
         auto operator* ()       -> T&;
         auto operator* () const -> T const&;
 
     public:
         using node_t = brodal_node<T, Compare, Allocator>;
-        T       data_;
-        node_t* node_;
+        node_t* node_ {nullptr};
+    };
+
+    /**
+        Links of a node that is in a violation set or owns one.
+        Only a few nodes have them so they are kept out of the node.
+     */
+    template<class T, class Compare, class Allocator>
+    struct brodal_set_links
+    {
+        using node_t = brodal_node<T, Compare, Allocator>;
+
+        node_t* nextInSet_ {nullptr};
+        node_t* prevInSet_ {nullptr};
+        node_t* setW_      {nullptr};
+        node_t* setV_      {nullptr};
+    };
+
+    /**
+        Slab of cells of one type. Cells are carved out of geometrically
+        growing chunks and reused through a free list. Chunks of another
+        slab can be spliced in, its cells stay where they are.
+     */
+    template<class Cell, class Allocator>
+    class brodal_slab
+    {
+    public:
+        brodal_slab  (Allocator const& alloc);
+        brodal_slab  (brodal_slab const&) = delete;
+        brodal_slab  (brodal_slab&& other) noexcept;
+        ~brodal_slab ();
+
+        auto operator= (brodal_slab const&) -> brodal_slab& = delete;
+
+        template<class... Args>
+        auto create        (Args&&... args)            -> Cell*;
+        auto destroy       (Cell* const cell)          -> void;
+        auto reserve       (std::size_t const count)   -> void;
+        auto splice        (brodal_slab& other)        -> void;
+        auto swap          (brodal_slab& other) noexcept -> void;
+        auto get_allocator () const                    -> Allocator;
+
+    private:
+        struct free_cell
+        {
+            free_cell* next_;
+        };
+
+        struct alignas(Cell) alignas(free_cell) slot
+        {
+            std::byte bytes_[std::max(sizeof(Cell), sizeof(free_cell))];
+        };
+
+        struct chunk
+        {
+            chunk*      next_;
+            std::size_t size_;
+        };
+
+        using type_alloc_traits = std::allocator_traits<Allocator>;
+        using slot_alloc_traits = typename type_alloc_traits::template rebind_traits<slot>;
+        using slot_alloc_t      = typename type_alloc_traits::template rebind_alloc<slot>;
+        using cell_alloc_traits = typename type_alloc_traits::template rebind_traits<Cell>;
+        using cell_alloc_t      = typename type_alloc_traits::template rebind_alloc<Cell>;
+
+        inline static constexpr auto FIRST_CHUNK_SIZE = std::size_t {16};
+        inline static constexpr auto MAX_CHUNK_SIZE   = std::size_t {4096};
+        inline static constexpr auto HEADER_SLOTS     = (sizeof(chunk) + sizeof(slot) - 1) / sizeof(slot);
+
+    private:
+        auto new_chunk (std::size_t const size) -> void;
+
+    private:
+        slot_alloc_t alloc_;
+        chunk*       chunks_    {nullptr};
+        chunk*       lastChunk_ {nullptr};
+        free_cell*   free_      {nullptr};
+        free_cell*   freeTail_  {nullptr};
+        slot*        next_      {nullptr};
+        slot*        end_       {nullptr};
+        std::size_t  chunkSize_ {FIRST_CHUNK_SIZE};
     };
 
     /**
-        Node of a brodal tree.
+        Node of a brodal tree. While the queue is small its nodes
+        are kept in an array heap and rank_ holds their index there.
      */
     template<class T, class Compare, class Allocator>
     class brodal_node
@@ -116,37 +260,44 @@ namespace idril
     public:
         using rank_t     = std::uint8_t;
         using num_t      = std::uint8_t;
-        using node_map   = std::unordered_map<brodal_node const*, brodal_node*>;
         using entry_t    = brodal_entry<T, Compare, Allocator>;
         using node_t     = brodal_node;
         using delinked_t = delinked_nodes<T, Compare, Allocator>;
+        using links_t    = brodal_set_links<T, Compare, Allocator>;
+        using links_slab = brodal_slab<links_t, Allocator>;
 
     public:
-        brodal_node (entry_t* entry);
+        template<class... Args>
+        brodal_node (entry_t* entry, std::in_place_t, Args&&... args);
         brodal_node (entry_t* entry, brodal_node const& other);
         
-        auto operator<         (node_t const& other) const -> bool;
         auto add_child         (node_t* const newChild)    -> void;
         auto remove_child      (node_t* const oldChild)    -> void;
         auto add_right_sibling (node_t* const sibling)     -> void;
-        auto add_to_W          (node_t* const node)        -> void;
-        auto add_to_V          (node_t* const node)        -> void;
-        auto add_set_sibling   (node_t* const sibling)     -> void;
+        auto add_to_W          (node_t* const node, links_slab& links)    -> void;
+        auto add_to_V          (node_t* const node, links_slab& links)    -> void;
+        auto add_set_sibling   (node_t* const sibling, links_slab& links) -> void;
+        auto reset             (links_slab& links)                         -> node_t*;
 
         auto operator*         ()       -> T&;
         auto operator*         () const -> T const&;
         auto disconnect_sons   ()       -> node_t*;
         auto disconnect        ()       -> node_t*;
-        auto reset             ()       -> node_t*;
         auto set_rank          ()       -> void;
         auto same_rank_sibling () const -> node_t*;
         auto is_son_of_root    () const -> bool;
-        auto is_violating      () const -> bool;
+        auto is_violating      (Compare const& compare) const -> bool;
         auto is_in_set         () const -> bool;
         auto is_first_in_W_set () const -> bool;
         auto is_first_in_V_set () const -> bool;
-
-        static auto remove_from_set     (node_t* const node)       -> void;
+        auto next_in_set       () const -> node_t*;
+        auto prev_in_set       () const -> node_t*;
+        auto first_in_W        () const -> node_t*;
+        auto first_in_V        () const -> node_t*;
+        auto set_links         (links_slab& links) -> links_t&;
+        auto release_links     (links_slab& links) -> void;
+
+        static auto remove_from_set     (node_t* const node, links_slab& links) -> void;
         static auto copy_list           (node_t* const first)      -> node_t*;
         static auto delink_node         (node_t* const node)       -> delinked_t;
         static auto same_rank_count     (node_t const* const node) -> num_t;
@@ -154,10 +305,9 @@ namespace idril
         static auto are_siblings        (node_t* const first, node_t* const second)    -> bool;
         static auto swap_entries        (node_t* const first, node_t* const second)    -> void;
         static auto swap_tree_nodes     (node_t* const first, node_t* const second)    -> void;
-        static auto make_siblings       (node_t* const first, node_t* const second)    -> void;
-        static auto copy_set            (node_t* const first, node_map const& mapping) -> node_t*;
-        static auto link_nodes          (node_t* const n1, node_t* const n2, node_t* const n3) -> node_t*;
-        static auto max_prio_node       (node_t* const n1, node_t* const n2, node_t* const n3) -> node_t*;
+        static auto make_siblings       (node_t* const first, node_t* const second, Compare const& compare) -> void;
+        static auto link_nodes          (node_t* const n1, node_t* const n2, node_t* const n3, Compare const& compare) -> node_t*;
+        static auto max_prio_node       (node_t* const n1, node_t* const n2, node_t* const n3, Compare const& compare) -> node_t*;
 
         template<class PrevFucntion, class NextFunction>
         static auto same_rank_impl (node_t const* const node, PrevFucntion prev, NextFunction next) -> num_t;
@@ -178,16 +328,17 @@ namespace idril
         static auto zip_with (node_t* const first1, node_t* const first2, BinaryFunction func) -> void;
         
     public:
+        T        data_;
         rank_t   rank_      {0};
+        // Rank under which the node was added to the W set of t1. Rank
+        // of the node itself can change while it is in the set.
+        rank_t   listedRank_ {0};
         entry_t* entry_     {nullptr};
         node_t*  parent_    {nullptr};
         node_t*  left_      {nullptr};
         node_t*  right_     {nullptr};
         node_t*  child_     {nullptr};
-        node_t*  nextInSet_ {nullptr};
-        node_t*  prevInSet_ {nullptr};
-        node_t*  setW_      {nullptr};
-        node_t*  setV_      {nullptr};
+        links_t* setLinks_  {nullptr};
     };
 
     /**
@@ -244,29 +395,30 @@ namespace idril
     /**
         Wrapper for the root of a tree.
      */
-    template<class Tree, class T, class Compare, class Allocator>
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
     class root_wrap
     {
     public:
         using node_t        = brodal_node<T, Compare, Allocator>;
-        using queue_t       = brodal_queue<T, Compare, Allocator>;
+        using queue_t       = brodal_queue<T, Compare, Allocator, Policy>;
         using num_t         = std::uint8_t;
         using rank_t        = std::uint8_t;
         using delinked_t    = delinked_nodes<T, Compare, Allocator>;
-        using node_map      = std::unordered_map<node_t const*, node_t*>;
         using up_reducer_t  = upper_reducer<root_wrap, T, Compare, Allocator>;
         using low_reducer_t = lower_reducer<root_wrap, T, Compare, Allocator>;
         using up_guide_t    = guide<up_reducer_t>;
         using low_guide_t   = guide<low_reducer_t>;
 
         template<class AnyTree>
-        using any_wrap_t    = root_wrap<AnyTree, T, Compare, Allocator>;
+        using any_wrap_t    = root_wrap<AnyTree, T, Compare, Allocator, Policy>;
 
     public:
         root_wrap  (queue_t* const queue);
         root_wrap  (queue_t* const queue, root_wrap const& other);
         root_wrap  (queue_t* const queue, root_wrap&& other) noexcept;
-        
+
+        auto operator= (root_wrap&& other) -> root_wrap&;
+
         template<class AnyTree>
         auto operator= (any_wrap_t<AnyTree>&& other) -> root_wrap&;
 
@@ -297,6 +449,7 @@ namespace idril
     public:
         auto upper_check_n_minus_1 () -> void;
         auto upper_check_n_minus_2 () -> void;
+        auto reduce_all_sons       () -> void;
         auto lower_check_n_minus_1 () -> void;
         auto lower_check_n_minus_2 (num_t const bound) -> num_t;
         auto link_children         (rank_t const rank) -> node_t*;
@@ -305,27 +458,26 @@ namespace idril
     public:
         queue_t*             queue_ {nullptr};
         node_t*              root_  {nullptr};
+        std::vector<node_t*> sons_;
         guide<up_reducer_t>  upper_ {up_reducer_t  {this}};
         guide<low_reducer_t> lower_ {low_reducer_t {this}};
-        std::vector<node_t*> sons_;
     };
 
     /**
         Wrapper for the T1 tree.
      */
-    template<class T, class Compare, class Allocator>
-    class t1_wrap : public root_wrap<t1_wrap<T, Compare, Allocator>, T, Compare, Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
+    class t1_wrap : public root_wrap<t1_wrap<T, Compare, Allocator, Policy>, T, Compare, Allocator, Policy>
     {
     public:
         using node_t         = brodal_node<T, Compare, Allocator>;
-        using queue_t        = brodal_queue<T, Compare, Allocator>;
+        using queue_t        = brodal_queue<T, Compare, Allocator, Policy>;
         using num_t          = std::uint8_t;
         using rank_t         = std::uint8_t;
         using delinked_t     = delinked_nodes<T, Compare, Allocator>;
-        using node_map       = std::unordered_map<node_t const*, node_t*>;
         using node_ptr_pair  = std::pair<node_t*, node_t*>;
         using viol_reducer_t = violation_reducer<t1_wrap, T, Compare, Allocator>;
-        using base_t         = root_wrap<t1_wrap, T, Compare, Allocator>;
+        using base_t         = root_wrap<t1_wrap, T, Compare, Allocator, Policy>;
 
     public:
         t1_wrap (queue_t* const queue);
@@ -370,28 +522,34 @@ namespace idril
 
         auto remove_normal_violations (node_t* const first, node_t* const second) -> num_t;
 
+        /// Rank of a node in the set can change after it was added
+        /// e.g. when its sons are delinked. Such node no longer
+        /// represents violations of given rank and it is forgotten.
+        /// @return First violation of given rank or nullptr.
+        auto first_violation (rank_t const rank) -> node_t*;
+
     public:
         guide<viol_reducer_t> violation_ {viol_reducer_t {this}};
         std::vector<node_t*>  auxW_;
     };
 
-    template<class T, class Compare, class Allocator>
-    auto swap ( t1_wrap<T, Compare, Allocator>& lhs 
-              , t1_wrap<T, Compare, Allocator>& rhs ) noexcept -> void;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto swap ( t1_wrap<T, Compare, Allocator, Policy>& lhs 
+              , t1_wrap<T, Compare, Allocator, Policy>& rhs ) noexcept -> void;
 
     /**
         Wrapper for the T2 tree.
      */
-    template<class T, class Compare, class Allocator>
-    class t2_wrap : public root_wrap<t2_wrap<T, Compare, Allocator>, T, Compare, Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
+    class t2_wrap : public root_wrap<t2_wrap<T, Compare, Allocator, Policy>, T, Compare, Allocator, Policy>
     {
     public:
         using node_t    = brodal_node<T, Compare, Allocator>;
-        using queue_t   = brodal_queue<T, Compare, Allocator>;
+        using queue_t   = brodal_queue<T, Compare, Allocator, Policy>;
         using num_t     = std::uint8_t;
         using rank_t    = std::uint8_t;
-        using base_t    = root_wrap<t2_wrap<T, Compare, Allocator>, T, Compare, Allocator>;
-        using t1_wrap_t = t1_wrap<T, Compare, Allocator>;
+        using base_t    = root_wrap<t2_wrap<T, Compare, Allocator, Policy>, T, Compare, Allocator, Policy>;
+        using t1_wrap_t = t1_wrap<T, Compare, Allocator, Policy>;
 
     public:
         t2_wrap (queue_t * const queue);
@@ -419,9 +577,9 @@ namespace idril
         auto swap (t2_wrap& rhs) noexcept   -> void;
     };
 
-    template<class T, class Compare, class Allocator>
-    auto swap ( t2_wrap<T, Compare, Allocator>& lhs 
-              , t2_wrap<T, Compare, Allocator>& rhs ) noexcept -> void;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto swap ( t2_wrap<T, Compare, Allocator, Policy>& lhs 
+              , t2_wrap<T, Compare, Allocator, Policy>& rhs ) noexcept -> void;
 
     /**
         Iterator of a single brodal tree.
@@ -452,7 +610,8 @@ namespace idril
         auto current () const -> node_t*;
 
     public:
-        std::stack<node_t*> stack_;
+        node_t* root_ {nullptr};
+        node_t* node_ {nullptr};
     };
 
     /**
@@ -473,6 +632,7 @@ namespace idril
     public:
         brodal_queue_iterator ();
         brodal_queue_iterator (node_t* const t1, node_t* const t2);
+        brodal_queue_iterator (node_t* const* const first, node_t* const* const last);
 
         auto operator++ ()       -> brodal_queue_iterator&;
         auto operator++ (int)    -> brodal_queue_iterator;
@@ -493,6 +653,8 @@ namespace idril
         tree_iterator_t  T1Iterator_;
         tree_iterator_t  T2Iterator_;
         active_it_e      activeIterator_;
+        node_t* const*   small_    {nullptr};
+        node_t* const*   smallEnd_ {nullptr};
     };
 
     /**
@@ -503,16 +665,18 @@ namespace idril
     class brodal_entry_handle
     {
     public:
+        brodal_entry_handle () = default;
+
         auto operator*  ()       -> T&;
         auto operator*  () const -> T const&;
         auto operator-> ()       -> T*;
         auto operator-> () const -> T const*;
 
     private:
-        friend class brodal_queue<T, Compare, Allocator>;
+        template<class, class, class, class> friend class brodal_queue;
         using entry_t = brodal_entry<T, Compare, Allocator>;
         brodal_entry_handle(entry_t* const node);
-        entry_t* entry_;
+        entry_t* entry_ {nullptr};
     };
 
     /**
@@ -524,9 +688,21 @@ namespace idril
         @tparam T           The type of the stored elements.
         @tparam Compare     Type providing a strict weak ordering.
                             See https://en.cppreference.com/w/cpp/named_req/Compare
+                            The queue stores one instance so it can carry state.
+                            Melded queues must order elements the same way.
         @tparam Allocator   Allocator. See https://en.cppreference.com/w/cpp/named_req/Allocator
+        @tparam Policy      brodal_policy::worst_case or brodal_policy::relaxed.
+
+        A queue with at most small_size() elements keeps its nodes in an inline
+        4-ary array heap instead of the trees. It moves to the trees once it grows
+        past small_size() and back once it shrinks to half of it. Both moves take
+        O(small_size()) time. Handles stay valid across them. Melding a small
+        queue inserts its elements one by one so it also takes O(small_size()).
      */
-    template<class T, class Compare = std::less<T>, class Allocator = std::allocator<T>>
+    template< class T
+            , class Compare   = std::less<T>
+            , class Allocator = std::allocator<T>
+            , class Policy    = brodal_policy::worst_case >
     class brodal_queue
     {
     public:
@@ -540,9 +716,22 @@ namespace idril
         using size_type       = std::size_t;
         using handle_t        = brodal_entry_handle<T, Compare, Allocator>;
 
+    public:
+        /// Default and largest small_size().
+        inline static constexpr auto SMALL_SIZE     = size_type {16};
+        inline static constexpr auto SMALL_CAPACITY = size_type {64};
+
     public:
         brodal_queue  (Allocator const& alloc = Allocator());
+        brodal_queue  (Compare const& compare, Allocator const& alloc = Allocator());
         brodal_queue  (brodal_queue const&);
+
+        /// Builds the queue from elements in [first, last) in linear time.
+        template<std::input_iterator InputIt>
+        brodal_queue ( InputIt first, InputIt last
+                     , Compare const& compare = Compare()
+                     , Allocator const& alloc = Allocator() );
+
         brodal_queue  (brodal_queue&&) noexcept;
         ~brodal_queue ();
 
@@ -566,7 +755,16 @@ namespace idril
         auto size         () const                     -> size_type;
         auto max_size     () const                     -> size_type;
         auto empty        () const                     -> bool;
+        auto small_size   () const                     -> size_type;
+        auto small_size   (size_type const size)       -> void;
         auto clear        ()                           -> void;
+
+        /// Moves min(k, size()) smallest elements to out in ascending
+        /// order and removes them. If k is a large part of the size the
+        /// queue is rebuilt once instead of repaired after each removal.
+        template<class OutputIt>
+        auto pop_n (size_type k, OutputIt out) -> OutputIt;
+
         auto begin        ()                           -> iterator;
         auto end          ()                           -> iterator;
         auto begin        () const                     -> const_iterator;
@@ -580,30 +778,48 @@ namespace idril
         using rank_t             = index_t;
         using node_t             = brodal_node<T, Compare, Allocator>;
         using entry_t            = brodal_entry<T, Compare, Allocator>;
+        using node_slab_t        = brodal_slab<node_t, Allocator>;
+        using entry_slab_t       = brodal_slab<entry_t, Allocator>;
+        using links_slab_t       = typename node_t::links_slab;
         using type_alloc_traits  = std::allocator_traits<Allocator>;
-        using entry_alloc_traits = typename type_alloc_traits::template rebind_traits<entry_t>;
-        using node_alloc_traits  = typename type_alloc_traits::template rebind_traits<node_t>;
-        using node_alloc_t       = typename type_alloc_traits::template rebind_alloc<node_t>;
-        using entry_alloc_t      = typename type_alloc_traits::template rebind_alloc<entry_t>;
-        using node_map           = std::unordered_map<node_t const*, node_t*>;
+        using node_pair          = std::pair<node_t const*, node_t*>;
+        using node_pairs         = std::vector<node_pair>;
         using node_ptr_pair      = std::pair<node_t*, node_t*>;
-        using node_stack_t       = std::stack<node_t*>;
-        using t1_wrap_t          = t1_wrap<T, Compare, Allocator>;
-        using t2_wrap_t          = t2_wrap<T, Compare, Allocator>;
+        using node_stack_t       = std::vector<node_t*>;
+        using t1_wrap_t          = t1_wrap<T, Compare, Allocator, Policy>;
+        using t2_wrap_t          = t2_wrap<T, Compare, Allocator, Policy>;
+        using small_heap_t       = std::array<node_t*, SMALL_CAPACITY>;
+
+        inline static constexpr auto SMALL_ARITY  = size_type {4};
+        inline static constexpr auto IS_RELAXED   = std::is_same_v<Policy, brodal_policy::relaxed>;
+
+        /// pop_n rebuilds the queue if it pops more than size() / POP_REBUILD_RATIO.
+        inline static constexpr auto POP_REBUILD_RATIO = size_type {16};
+
+        /// Operations the relaxed policy defers before it repairs the trees.
+        /// Keeps the 8-bit counts of sons and violations from overflowing.
+        inline static constexpr auto MAX_DEFERRED = std::uint8_t {64};
+
+        static_assert( SMALL_SIZE >= 2
+                     , "Trees built from a range need at least three nodes." );
+
+        static_assert( SMALL_CAPACITY <= std::numeric_limits<index_t>::max()
+                     , "Index in the small heap must fit into the rank of a node." );
 
     private:
         template<class... Args>
         auto new_node (Args&&... args) -> node_t*;
-        
-        template<class... Args>
-        auto new_entry (Args&&... args) -> entry_t*;
 
-        template<class Cmp = Compare>
         auto dec_key_impl (node_t* const node) -> void;
+        auto build        (node_stack_t& nodes) -> void;
+
+        template<class OutputIt>
+        auto pop_n_rebuild (size_type const k, OutputIt out) -> OutputIt;
 
         template<class RootWrap>
         auto pick_T2 (RootWrap& wrap) -> void;
 
+        auto delete_min_impl      ()       -> void;
         auto delete_min_special   ()       -> void;
         auto add_extra_nodes      ()       -> void;
         auto add_violations       ()       -> void;
@@ -611,89 +827,156 @@ namespace idril
         auto move_all_to_T1       ()       -> void;
         auto move_to_T1           ()       -> void;
         auto find_new_root        () const -> node_t*;
+        auto is_small             () const -> bool;
+        auto promote              ()       -> void;
+        auto demote               ()       -> void;
+        auto repair               ()       -> void;
+        auto sift_up              (index_t i)                 -> void;
+        auto sift_down            (index_t i)                 -> void;
+        auto defer                (std::uint8_t& counter)     -> void;
         auto add_under_t1         (node_t*& root)             -> void;
         auto add_under_t2         (node_t*& root)             -> void;
-        auto shallow_copy_node    (node_t* const node)        -> node_t*;
+        auto delink_under_t1      (node_t* const node)        -> void;
+        auto shallow_copy_node    (node_t const* const node)  -> node_t*;
         auto delete_node          (node_t* const node)        -> void;
-        auto delete_entry         (entry_t* const entry)      -> void;
+        auto delete_tree          (node_t* node)              -> void;
         auto insert_impl          (node_t* const node)        -> handle_t;
+        auto insert_tree_impl     (node_t* const node)        -> handle_t;
+        auto insert_small_impl    (node_t* const node)        -> handle_t;
         auto insert_special_impl  (node_t* const node)        -> handle_t;
         auto erase_impl           (node_t* const node)        -> void;
+        auto erase_small_impl     (node_t* const node)        -> void;
         auto make_son_of_root     (node_t* const newRoot)     -> void;
         auto merge_sets           (node_t* const newRoot)     -> void;
         auto swallow              (brodal_queue& other)       -> brodal_queue&;
-        auto shallow_copy_nodes   (brodal_queue const& other) -> node_map;
-        auto deep_copy_tree       (node_map const& map)       -> void;
-        auto deep_copy_violations (node_map const& map)       -> void;
-        auto deep_copy_wraps      (brodal_queue const& other, node_map const& map) -> void;
+        auto deep_copy_tree       (node_t const* const root, node_pairs& linked) -> node_t*;
+        auto deep_copy_violations (node_pairs& linked)        -> void;
+        auto deep_copy_wraps      (node_pairs const& linked)  -> void;
+
+        static auto copy_of (node_pairs const& linked, node_t const* const node) -> node_t*;
 
     private:
-        friend class root_wrap<t1_wrap_t, T, Compare, Allocator>;
-        friend class root_wrap<t2_wrap_t, T, Compare, Allocator>;
-        friend class t1_wrap<T, Compare, Allocator>;
-        friend class t2_wrap<T, Compare, Allocator>;
+        friend class root_wrap<t1_wrap_t, T, Compare, Allocator, Policy>;
+        friend class root_wrap<t2_wrap_t, T, Compare, Allocator, Policy>;
+        friend class t1_wrap<T, Compare, Allocator, Policy>;
+        friend class t2_wrap<T, Compare, Allocator, Policy>;
 
     private:
         std::size_t   size_;
+        std::size_t   smallSize_;
+        std::uint8_t  deferredSons_;
+        std::uint8_t  deferredViolations_;
+        [[no_unique_address]]
+        Compare       compare_;
         t1_wrap_t     T1_;
         t2_wrap_t     T2_;
-        node_alloc_t  nodeAllocator_;
-        entry_alloc_t entryAllocator_;
+        node_slab_t   nodes_;
+        entry_slab_t  entries_;
+        links_slab_t  links_;
         node_stack_t  extraNodes_;
         node_stack_t  violations_;
+        small_heap_t  small_;
     };
 
-    template<class T, class Compare, class Allocator>
-    auto swap( brodal_queue<T, Compare, Allocator>& first 
-             , brodal_queue<T, Compare, Allocator>& second ) noexcept -> void;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto swap( brodal_queue<T, Compare, Allocator, Policy>& first 
+             , brodal_queue<T, Compare, Allocator, Policy>& second ) noexcept -> void;
 
-    template<class T, class Compare, class Allocator>
-    auto meld( brodal_queue<T, Compare, Allocator>& first 
-             , brodal_queue<T, Compare, Allocator>& second ) -> brodal_queue<T, Compare, Allocator>;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto meld( brodal_queue<T, Compare, Allocator, Policy>& first 
+             , brodal_queue<T, Compare, Allocator, Policy>& second ) -> brodal_queue<T, Compare, Allocator, Policy>;
 
-    template<class T, class Compare, class Allocator>
-    auto operator== ( brodal_queue<T, Compare, Allocator> const& lhs
-                    , brodal_queue<T, Compare, Allocator> const& rhs ) -> bool;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto operator== ( brodal_queue<T, Compare, Allocator, Policy> const& lhs
+                    , brodal_queue<T, Compare, Allocator, Policy> const& rhs ) -> bool;
 
-    template<class T, class Compare, class Allocator>
-    auto operator!= ( brodal_queue<T, Compare, Allocator> const& lhs
-                    , brodal_queue<T, Compare, Allocator> const& rhs ) -> bool;
+    template<class T, class Compare, class Allocator, class Policy>
+    auto operator!= ( brodal_queue<T, Compare, Allocator, Policy> const& lhs
+                    , brodal_queue<T, Compare, Allocator, Policy> const& rhs ) -> bool;
 
 // guide definition:
 
-    namespace guide_impl
+    inline guide_blocks::guide_blocks
+        ()
     {
-        template<class Vector, class Index>
-        auto copy_blocks (Vector const& vs, Index const null)
+        ids_.fill(NULL_BLOCK);
+        refs_.fill(0);
+        for (auto id = std::size_t {0}; id < CAPACITY; ++id)
         {
-            using val_t = typename Vector::value_type::element_type;
+            starts_[id] = id + 1 < CAPACITY ? static_cast<index_t>(id + 1) : NULL_BLOCK;
+        }
+    }
 
-            auto newVs = Vector();
-            newVs.reserve(vs.size());
+    inline auto guide_blocks::size
+        () const -> index_t
+    {
+        return size_;
+    }
 
-            auto it  = std::begin(vs);
-            auto end = std::end(vs);
+    inline auto guide_blocks::block_of
+        (index_t const i) const -> index_t
+    {
+        auto const id = ids_[i];
+        return id == NULL_BLOCK ? NULL_BLOCK : starts_[id];
+    }
 
-            while (it != end)
-            {
-                auto const block = **it;
+    inline auto guide_blocks::push_back
+        () -> void
+    {
+        ids_[size_] = NULL_BLOCK;
+        ++size_;
+    }
 
-                if (null == block)
-                {
-                    newVs.push_back(std::make_shared<val_t>(block));
-                    ++it;
-                    continue;
-                }
+    inline auto guide_blocks::pop_back
+        () -> void
+    {
+        --size_;
+        this->set_id(size_, NULL_BLOCK);
+    }
 
-                auto const newBlock = std::make_shared<val_t>(block);
-                while (it != end and **it == *newBlock)
-                {
-                    newVs.push_back(newBlock);
-                    ++it;
-                }
-            }
+    inline auto guide_blocks::make_block
+        (index_t const i) -> void
+    {
+        // Release old ids first so that there is always a free one.
+        this->set_id(i, NULL_BLOCK);
+        this->set_id(i + 1, NULL_BLOCK);
+
+        auto const id = freeId_;
+        freeId_       = starts_[id];
+        starts_[id]   = i + 1;
+        this->set_id(i, id);
+        this->set_id(i + 1, id);
+    }
+
+    inline auto guide_blocks::join_next
+        (index_t const i) -> void
+    {
+        this->set_id(i, ids_[i + 1]);
+    }
+
+    inline auto guide_blocks::cancel
+        (index_t const i) -> void
+    {
+        if (ids_[i] != NULL_BLOCK)
+        {
+            starts_[ids_[i]] = NULL_BLOCK;
+        }
+    }
+
+    inline auto guide_blocks::set_id
+        (index_t const i, index_t const id) -> void
+    {
+        auto const oldId = ids_[i];
+        ids_[i]          = id;
+        if (id != NULL_BLOCK)
+        {
+            ++refs_[id];
+        }
 
-            return newVs;
+        if (oldId != NULL_BLOCK && 0 == --refs_[oldId])
+        {
+            starts_[oldId] = freeId_;
+            freeId_        = oldId;
         }
     }
 
@@ -701,7 +984,7 @@ namespace idril
     guide<Reducer>::guide
         (guide&& other) noexcept :
         reducer_ {std::move(other.reducer_)},
-        blocks_  {std::move(other.blocks_)}
+        blocks_  {other.blocks_}
     {
     }
 
@@ -709,7 +992,7 @@ namespace idril
     guide<Reducer>::guide
         (Reducer reducer, guide const& other) :
         reducer_ {std::move(reducer)},
-        blocks_  {guide_impl::copy_blocks(other.blocks_, NULL_BLOCK)}
+        blocks_  {other.blocks_}
     {
     }
 
@@ -717,7 +1000,7 @@ namespace idril
     guide<Reducer>::guide
         (Reducer reducer, guide&& other) noexcept :
         reducer_ {std::move(reducer)},
-        blocks_  {std::move(other.blocks_)}
+        blocks_  {other.blocks_}
     {
     }
 
@@ -728,20 +1011,12 @@ namespace idril
     {
     }
 
-    template<class Reducer>
-    guide<Reducer>::guide
-        (Reducer reducer, blocks_v blocks) :
-        reducer_ {std::move(reducer)},
-        blocks_  {std::move(blocks)}
-    {
-    }
-
     template<class Reducer>
     template<class R>
     guide<Reducer>::guide
         (Reducer reducer, guide<R>&& other) noexcept :
         reducer_ {reducer},
-        blocks_  {std::move(other.blocks_)}
+        blocks_  {other.blocks_}
     {
     }
 
@@ -772,7 +1047,7 @@ namespace idril
     auto guide<Reducer>::increase_domain
         () -> void
     {
-        blocks_.push_back(std::make_shared<index_t>(NULL_BLOCK));
+        blocks_.push_back();
         this->inc(blocks_.size() - 1);
     }
 
@@ -784,6 +1059,18 @@ namespace idril
         blocks_.pop_back();
     }
 
+    template<class Reducer>
+    auto guide<Reducer>::reset
+        () -> void
+    {
+        auto const size = blocks_.size();
+        blocks_ = guide_blocks();
+        for (auto i = index_t {0}; i < size; ++i)
+        {
+            blocks_.push_back();
+        }
+    }
+
     template<class Reducer>
     auto guide<Reducer>::to_string
         () const -> std::string
@@ -798,11 +1085,10 @@ namespace idril
         }
         out += '\n';
 
-        auto it  = std::rbegin(blocks_);
-        auto end = std::rend(blocks_);
-        while (it != end)
+        for (auto i = blocks_.size(); i > 0;)
         {
-            auto const bn = **it++;
+            --i;
+            auto const bn = blocks_.block_of(i);
             out += bn == NULL_BLOCK ? "-" : std::to_string(bn);
         }
         out += '\n';
@@ -831,7 +1117,7 @@ namespace idril
 
         if (this->is_last_in_block(i))
         {
-            auto const blockBeginIndex = *blocks_[i];
+            auto const blockBeginIndex = blocks_.block_of(i);
             this->cancel_block(blockBeginIndex);
             this->inc_out_block(blockBeginIndex);
         }
@@ -846,7 +1132,7 @@ namespace idril
         }
         else
         {
-            auto const blockBeginIndex = *blocks_[i];
+            auto const blockBeginIndex = blocks_.block_of(i);
             this->cancel_block(i);
             this->inc_out_block(blockBeginIndex);
             this->inc_out_block(i);
@@ -868,12 +1154,11 @@ namespace idril
 
         if (this->is_in_block(i + 1) && reducer_.get_num(i + 1) == 1u)
         {
-            blocks_[i] = blocks_[i + 1];
+            blocks_.join_next(i);
         }
         else if (i + 1u < blocks_.size() && reducer_.get_num(i + 1) == 2)
         {
-            blocks_[i]     = std::make_shared<index_t>(i + 1);
-            blocks_[i + 1] = blocks_[i];
+            blocks_.make_block(i);
         }
     }
 
@@ -881,15 +1166,15 @@ namespace idril
     auto guide<Reducer>::cancel_block
         (index_t const i) -> void
     {
-        *blocks_[i] = NULL_BLOCK;
+        blocks_.cancel(i);
     }
 
     template<class Reducer>
     auto guide<Reducer>::is_in_block
         (index_t const i) -> bool
     {
-        return i < blocks_.size() 
-            && *blocks_[i] != NULL_BLOCK;
+        return i < blocks_.size()
+            && blocks_.block_of(i) != NULL_BLOCK;
     }
 
     template<class Reducer>
@@ -897,15 +1182,15 @@ namespace idril
         (index_t const i) -> bool
     {
         return i + 1u == blocks_.size()
-            || *blocks_[i] != *blocks_[i + 1];
+            || blocks_.block_of(i) != blocks_.block_of(i + 1);
     }
 
     template<class Reducer>
     auto guide<Reducer>::is_last_in_block
         (index_t const i) -> bool
     {
-        return 0 == i 
-            || *blocks_[i] != *blocks_[i - 1];
+        return 0 == i
+            || blocks_.block_of(i) != blocks_.block_of(i - 1);
     }
 
     template<class Reducer>
@@ -941,34 +1226,201 @@ namespace idril
 
 // brodal_entry definition:
 
-    template<class T, class Compare, class Allocator>
-    template<class... Args>
-    brodal_entry<T, Compare, Allocator>::brodal_entry
-        (Args&&... args) :
-        data_ {std::forward<Args>(args)...},
-        node_ {nullptr}
-    {
-    }
-
     template<class T, class Compare, class Allocator>
     auto brodal_entry<T, Compare, Allocator>::operator*
         () -> T&
     {
-        return data_;
+        return **node_;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_entry<T, Compare, Allocator>::operator*
         () const -> T const&
     {
-        return data_;
+        return **node_;
+    }
+
+// brodal_slab definition:
+
+    template<class Cell, class Allocator>
+    brodal_slab<Cell, Allocator>::brodal_slab
+        (Allocator const& alloc) :
+        alloc_ {alloc}
+    {
+    }
+
+    template<class Cell, class Allocator>
+    brodal_slab<Cell, Allocator>::brodal_slab
+        (brodal_slab&& other) noexcept :
+        alloc_     {std::move(other.alloc_)},
+        chunks_    {std::exchange(other.chunks_, nullptr)},
+        lastChunk_ {std::exchange(other.lastChunk_, nullptr)},
+        free_      {std::exchange(other.free_, nullptr)},
+        freeTail_  {std::exchange(other.freeTail_, nullptr)},
+        next_      {std::exchange(other.next_, nullptr)},
+        end_       {std::exchange(other.end_, nullptr)},
+        chunkSize_ {std::exchange(other.chunkSize_, FIRST_CHUNK_SIZE)}
+    {
+    }
+
+    template<class Cell, class Allocator>
+    brodal_slab<Cell, Allocator>::~brodal_slab
+        ()
+    {
+        while (chunks_)
+        {
+            auto const c = std::exchange(chunks_, chunks_->next_);
+            slot_alloc_traits::deallocate(alloc_, reinterpret_cast<slot*>(c), c->size_);
+        }
+    }
+
+    template<class Cell, class Allocator>
+    template<class... Args>
+    auto brodal_slab<Cell, Allocator>::create
+        (Args&&... args) -> Cell*
+    {
+        if (not free_ and next_ == end_)
+        {
+            this->new_chunk(chunkSize_);
+        }
+
+        // Construction overwrites the free list link, so it is read first.
+        // The cell is taken only after its construction succeeded.
+        auto const free = free_;
+        auto const next = free ? free->next_ : nullptr;
+        auto const cell = free
+            ? reinterpret_cast<Cell*>(free)
+            : reinterpret_cast<Cell*>(next_);
+        auto cellAlloc = cell_alloc_t {alloc_};
+        cell_alloc_traits::construct(cellAlloc, cell, std::forward<Args>(args)...);
+
+        if (free)
+        {
+            free_ = next;
+            if (not free_)
+            {
+                freeTail_ = nullptr;
+            }
+        }
+        else
+        {
+            ++next_;
+        }
+
+        return std::launder(cell);
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::destroy
+        (Cell* const cell) -> void
+    {
+        auto cellAlloc = cell_alloc_t {alloc_};
+        cell_alloc_traits::destroy(cellAlloc, cell);
+        free_ = ::new (static_cast<void*>(cell)) free_cell {free_};
+        if (not freeTail_)
+        {
+            freeTail_ = free_;
+        }
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::reserve
+        (std::size_t const count) -> void
+    {
+        // Rest of the current chunk is left unused.
+        if (static_cast<std::size_t>(end_ - next_) < count)
+        {
+            this->new_chunk(HEADER_SLOTS + count);
+        }
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::splice
+        (brodal_slab& other) -> void
+    {
+        // Chunks are linked through their headers so the other list is
+        // prepended without touching the chunks in between.
+        // The emptier of the two current chunks is left unused.
+        if (other.chunks_)
+        {
+            other.lastChunk_->next_ = chunks_;
+            chunks_ = std::exchange(other.chunks_, nullptr);
+            if (not lastChunk_)
+            {
+                lastChunk_ = other.lastChunk_;
+            }
+            other.lastChunk_ = nullptr;
+        }
+
+        if (end_ - next_ < other.end_ - other.next_)
+        {
+            next_ = other.next_;
+            end_  = other.end_;
+        }
+        other.next_ = nullptr;
+        other.end_  = nullptr;
+        chunkSize_  = std::max(chunkSize_, std::exchange(other.chunkSize_, FIRST_CHUNK_SIZE));
+
+        if (other.free_)
+        {
+            other.freeTail_->next_ = free_;
+            if (not free_)
+            {
+                freeTail_ = other.freeTail_;
+            }
+            free_ = std::exchange(other.free_, nullptr);
+            other.freeTail_ = nullptr;
+        }
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::swap
+        (brodal_slab& other) noexcept -> void
+    {
+        using std::swap;
+        if constexpr (slot_alloc_traits::propagate_on_container_swap::value)
+        {
+            swap(alloc_, other.alloc_);
+        }
+        swap(chunks_,    other.chunks_);
+        swap(lastChunk_, other.lastChunk_);
+        swap(free_,      other.free_);
+        swap(freeTail_,  other.freeTail_);
+        swap(next_,      other.next_);
+        swap(end_,       other.end_);
+        swap(chunkSize_, other.chunkSize_);
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::get_allocator
+        () const -> Allocator
+    {
+        return Allocator(alloc_);
+    }
+
+    template<class Cell, class Allocator>
+    auto brodal_slab<Cell, Allocator>::new_chunk
+        (std::size_t const size) -> void
+    {
+        // Header of the chunk takes its first slots.
+        auto const slots = slot_alloc_traits::allocate(alloc_, size);
+        chunks_ = ::new (static_cast<void*>(slots)) chunk {chunks_, size};
+        if (not lastChunk_)
+        {
+            lastChunk_ = chunks_;
+        }
+        next_      = slots + HEADER_SLOTS;
+        end_       = slots + size;
+        chunkSize_ = std::min(MAX_CHUNK_SIZE, 2 * size);
     }
 
 // brodal_node definition:
 
     template<class T, class Compare, class Allocator>
+    template<class... Args>
     brodal_node<T, Compare, Allocator>::brodal_node
-        (entry_t* entry) :
+        (entry_t* entry, std::in_place_t, Args&&... args) :
+        data_  {std::forward<Args>(args)...},
         entry_ {entry}
     {
         entry->node_ = this;
@@ -977,38 +1429,30 @@ namespace idril
     template<class T, class Compare, class Allocator>
     brodal_node<T, Compare, Allocator>::brodal_node
         (entry_t* entry, brodal_node const& other) :
+        data_      {other.data_},
         rank_      {other.rank_},
+        listedRank_ {other.listedRank_},
         entry_     {entry},
         parent_    {other.parent_},
         left_      {other.left_},
         right_     {other.right_},
-        child_     {other.child_},
-        nextInSet_ {other.nextInSet_},
-        prevInSet_ {other.prevInSet_},
-        setW_      {other.setW_},
-        setV_      {other.setV_}
+        child_     {other.child_}
     {
+        entry->node_ = this;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::operator*
         () -> T&
     {
-        return **entry_;
+        return data_;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::operator*
         () const -> T const&
     {
-        return **entry_;
-    }
-
-    template<class T, class Compare, class Allocator>
-    auto brodal_node<T, Compare, Allocator>::operator<
-        (brodal_node const& other) const -> bool
-    {
-        return Compare {} (**this, *other);
+        return data_;
     }
 
     template<class T, class Compare, class Allocator>
@@ -1075,45 +1519,54 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::add_to_W
-        (node_t* const node) -> void
+        (node_t* const node, links_slab& links) -> void
     {
-        if (setW_)
+        auto& owner = this->set_links(links);
+        auto& added = node->set_links(links);
+
+        if (owner.setW_)
         {
-            setW_->prevInSet_ = node;
+            owner.setW_->setLinks_->prevInSet_ = node;
         }
-        
-        node->nextInSet_ = setW_;
-        node->prevInSet_ = this;
-        setW_ = node;
+
+        added.nextInSet_ = owner.setW_;
+        added.prevInSet_ = this;
+        owner.setW_ = node;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::add_to_V
-        (node_t* const node) -> void
+        (node_t* const node, links_slab& links) -> void
     {
-        if (setV_)
+        auto& owner = this->set_links(links);
+        auto& added = node->set_links(links);
+
+        if (owner.setV_)
         {
-            setV_->prevInSet_ = node;
+            owner.setV_->setLinks_->prevInSet_ = node;
         }
 
-        node->nextInSet_ = setV_;
-        node->prevInSet_ = this;
-        setV_ = node;
+        added.nextInSet_ = owner.setV_;
+        added.prevInSet_ = this;
+        owner.setV_ = node;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::add_set_sibling
-        (node_t* const sibling) -> void
+        (node_t* const sibling, links_slab& links) -> void
     {
-        sibling->prevInSet_ = this;
-        sibling->nextInSet_ = nextInSet_;
-        
-        if (nextInSet_)
+        auto& added = sibling->set_links(links);
+        auto const next = setLinks_->nextInSet_;
+
+        added.prevInSet_ = this;
+        added.nextInSet_ = next;
+
+        if (next)
         {
-            nextInSet_->prevInSet_ = sibling;
+            next->setLinks_->prevInSet_ = sibling;
         }
-        
-        nextInSet_ = sibling; 
+
+        setLinks_->nextInSet_ = sibling;
     }
 
     template<class T, class Compare, class Allocator>
@@ -1144,16 +1597,18 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::reset
-        () -> node_t*
+        (links_slab& links) -> node_t*
     {
-        parent_    = nullptr;
-        left_      = nullptr;
-        right_     = nullptr;
-        child_     = nullptr;
-        prevInSet_ = nullptr;
-        nextInSet_ = nullptr;
-        setW_      = nullptr;
-        setV_      = nullptr;
+        rank_   = 0;
+        parent_ = nullptr;
+        left_   = nullptr;
+        right_  = nullptr;
+        child_  = nullptr;
+
+        if (setLinks_)
+        {
+            links.destroy(std::exchange(setLinks_, nullptr));
+        }
 
         return this;
     }
@@ -1191,35 +1646,89 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::is_violating
-        () const -> bool
+        (Compare const& compare) const -> bool
     {
-        return parent_ && *this < *parent_;
+        return parent_ && compare(data_, parent_->data_);
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::is_in_set
         () const -> bool
     {
-        return nullptr != prevInSet_;
+        return nullptr != this->prev_in_set();
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::is_first_in_W_set
         () const -> bool
     {
-        return prevInSet_ && prevInSet_->setW_ == this;
+        auto const prev = this->prev_in_set();
+        return prev && prev->first_in_W() == this;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::is_first_in_V_set
         () const -> bool
     {
-        return prevInSet_ && prevInSet_->setV_ == this;
+        auto const prev = this->prev_in_set();
+        return prev && prev->first_in_V() == this;
     }
 
     template<class T, class Compare, class Allocator>
-    auto brodal_node<T, Compare, Allocator>::are_siblings
-        (node_t* const first, node_t* const second) -> bool
+    auto brodal_node<T, Compare, Allocator>::next_in_set
+        () const -> node_t*
+    {
+        return setLinks_ ? setLinks_->nextInSet_ : nullptr;
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::prev_in_set
+        () const -> node_t*
+    {
+        return setLinks_ ? setLinks_->prevInSet_ : nullptr;
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::first_in_W
+        () const -> node_t*
+    {
+        return setLinks_ ? setLinks_->setW_ : nullptr;
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::first_in_V
+        () const -> node_t*
+    {
+        return setLinks_ ? setLinks_->setV_ : nullptr;
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::set_links
+        (links_slab& links) -> links_t&
+    {
+        if (not setLinks_)
+        {
+            setLinks_ = links.create();
+        }
+
+        return *setLinks_;
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::release_links
+        (links_slab& links) -> void
+    {
+        if ( setLinks_
+         and not setLinks_->nextInSet_ and not setLinks_->prevInSet_
+         and not setLinks_->setW_      and not setLinks_->setV_ )
+        {
+            links.destroy(std::exchange(setLinks_, nullptr));
+        }
+    }
+
+    template<class T, class Compare, class Allocator>
+    auto brodal_node<T, Compare, Allocator>::are_siblings
+        (node_t* const first, node_t* const second) -> bool
     {
         return first->parent_ == second->parent_;
     }
@@ -1229,8 +1738,10 @@ namespace idril
         (node_t* const first, node_t* const second) -> void
     {
         using std::swap;
+        swap(first->data_, second->data_);
         swap(first->entry_, second->entry_);
-        swap(first->entry_->node_, second->entry_->node_);
+        first->entry_->node_  = first;
+        second->entry_->node_ = second;
     }
 
     template<class T, class Compare, class Allocator>
@@ -1279,9 +1790,9 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::make_siblings
-        (node_t* const first, node_t* const second) -> void
+        (node_t* const first, node_t* const second, Compare const& compare) -> void
     {
-        if (*first->parent_ < *second->parent_)
+        if (compare(**first->parent_, **second->parent_))
         {
             node_t::swap_tree_nodes(first, second->same_rank_sibling());
         }
@@ -1306,41 +1817,39 @@ namespace idril
         (node_t const* const node) -> num_t
     {
         return node_t::same_rank_impl( node
-                                     , [](auto const n){ return n->prevInSet_; }
-                                     , [](auto const n){ return n->nextInSet_; });
+                                     , [](auto const n){ return n->prev_in_set(); }
+                                     , [](auto const n){ return n->next_in_set(); });
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::remove_from_set
-        (node_t* const node) -> void
+        (node_t* const node, links_slab& links) -> void
     {
+        auto const prev = node->setLinks_->prevInSet_;
+        auto const next = node->setLinks_->nextInSet_;
+
         if (node->is_first_in_W_set())
         {
-            node->prevInSet_->setW_ = node->nextInSet_;
-            if (node->nextInSet_)
-            {
-                node->nextInSet_->prevInSet_ = node->prevInSet_;
-            }
+            prev->setLinks_->setW_ = next;
         }
         else if (node->is_first_in_V_set())
         {
-            node->prevInSet_->setV_ = node->nextInSet_;
-            if (node->nextInSet_)
-            {
-                node->nextInSet_->prevInSet_ = node->prevInSet_;
-            }
+            prev->setLinks_->setV_ = next;
         }
         else
         {
-            node->prevInSet_->nextInSet_ = node->nextInSet_;
-            if (node->nextInSet_)
-            {
-                node->nextInSet_->prevInSet_ = node->prevInSet_;
-            }
+            prev->setLinks_->nextInSet_ = next;
         }
 
-        node->prevInSet_ = nullptr;
-        node->nextInSet_ = nullptr;
+        if (next)
+        {
+            next->setLinks_->prevInSet_ = prev;
+        }
+
+        node->setLinks_->prevInSet_ = nullptr;
+        node->setLinks_->nextInSet_ = nullptr;
+        node->release_links(links);
+        prev->release_links(links);
     }
 
     template<class T, class Compare, class Allocator>
@@ -1366,29 +1875,6 @@ namespace idril
         return newListFirst;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_node<T, Compare, Allocator>::copy_set
-        (node_t* const first, node_map const& mapping) -> node_t*
-    {
-        if (!first)
-        {
-            return nullptr;
-        }
-
-        auto newSetLast = mapping.at(first);
-        auto const newSetFirst = newSetLast;
-
-        node_t::fold_next(first->nextInSet_, [&](auto const n)
-        {
-            auto const mappedNode = mapping.at(n);
-            newSetLast->nextInSet_ = mappedNode;
-            mappedNode->prevInSet_ = newSetLast;
-            newSetLast            = mappedNode;
-        });
-
-        return newSetFirst;
-    }
-
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::delink_node
         (node_t* const node) -> delinked_t
@@ -1412,9 +1898,9 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::link_nodes
-        (node_t* const n1, node_t* const n2, node_t* const n3) -> node_t*
+        (node_t* const n1, node_t* const n2, node_t* const n3, Compare const& compare) -> node_t*
     {
-        auto const root = node_t::max_prio_node(n1, n2, n3);
+        auto const root = node_t::max_prio_node(n1, n2, n3, compare);
 
         if (n1 != root)
         {
@@ -1436,16 +1922,16 @@ namespace idril
 
     template<class T, class Compare, class Allocator>
     auto brodal_node<T, Compare, Allocator>::max_prio_node
-        (node_t* const n1, node_t* const n2, node_t* const n3) -> node_t*
+        (node_t* const n1, node_t* const n2, node_t* const n3, Compare const& compare) -> node_t*
     {
         auto max = n1;
 
-        if (*n2 < *max)
+        if (compare(**n2, **max))
         {
             max = n2;
         }
 
-        if (*n3 < *max)
+        if (compare(**n3, **max))
         {
             max = n3;
         }
@@ -1499,7 +1985,7 @@ namespace idril
     auto brodal_node<T, Compare, Allocator>::fold_next
         (node_t* const first, UnaryFunction func) -> void
     {
-        node_t::fold_impl(first, func, [](auto const n){ return n->nextInSet_; });
+        node_t::fold_impl(first, func, [](auto const n){ return n->next_in_set(); });
     }
 
     template<class T, class Compare, class Allocator>
@@ -1541,7 +2027,8 @@ namespace idril
     template<class T, class Compare, class Allocator>
     brodal_tree_iterator<T, Compare, Allocator>::brodal_tree_iterator
         (node_t* const root) :
-        stack_ {root ? std::deque {root} : std::deque<node_t*> {}}
+        root_ {root},
+        node_ {root}
     {
     }
 
@@ -1549,14 +2036,19 @@ namespace idril
     auto brodal_tree_iterator<T, Compare, Allocator>::operator++
         () -> brodal_tree_iterator&
     {
-        auto next = stack_.top()->child_;
-        stack_.pop();
-        while (next)
+        // Preorder walk through parent links, no stack is needed.
+        if (node_->child_)
+        {
+            node_ = node_->child_;
+            return *this;
+        }
+
+        while (node_ != root_ && !node_->right_)
         {
-            stack_.push(next);
-            next = next->right_;
+            node_ = node_->parent_;
         }
 
+        node_ = node_ == root_ ? nullptr : node_->right_;
         return *this;
     }
 
@@ -1573,23 +2065,21 @@ namespace idril
     auto brodal_tree_iterator<T, Compare, Allocator>::operator*
         () const -> reference
     {
-        return *stack_.top();
+        return *node_;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_tree_iterator<T, Compare, Allocator>::operator->
         () const -> pointer
     {
-        return stack_.top();
+        return node_;
     }
 
     template<class T, class Compare, class Allocator>
     auto brodal_tree_iterator<T, Compare, Allocator>::operator==
         (brodal_tree_iterator const& rhs) const -> bool
     {
-        return (stack_.empty() && rhs.stack_.empty())
-            || (stack_.size()  == rhs.stack_.size()
-            &&  stack_.top()   == rhs.stack_.top());
+        return node_ == rhs.node_;
     }
 
     template<class T, class Compare, class Allocator>
@@ -1611,7 +2101,9 @@ namespace idril
     template<class T, class Compare, class Allocator, bool IsConst>
     brodal_queue_iterator<T, Compare, Allocator, IsConst>::brodal_queue_iterator
         () :
-        brodal_queue_iterator<T, Compare, Allocator, IsConst> {nullptr, nullptr}
+        T1Iterator_     {},
+        T2Iterator_     {},
+        activeIterator_ {active_it_e::first}
     {
     }
 
@@ -1624,10 +2116,31 @@ namespace idril
     {
     }
 
+    template<class T, class Compare, class Allocator, bool IsConst>
+    brodal_queue_iterator<T, Compare, Allocator, IsConst>::brodal_queue_iterator
+        (node_t* const* const first, node_t* const* const last) :
+        T1Iterator_     {},
+        T2Iterator_     {},
+        activeIterator_ {active_it_e::first},
+        small_          {first != last ? first : nullptr},
+        smallEnd_       {first != last ? last : nullptr}
+    {
+    }
+
     template<class T, class Compare, class Allocator, bool IsConst>
     auto brodal_queue_iterator<T, Compare, Allocator, IsConst>::operator++
         () -> brodal_queue_iterator& 
     {
+        if (small_)
+        {
+            if (++small_ == smallEnd_)
+            {
+                small_    = nullptr;
+                smallEnd_ = nullptr;
+            }
+            return *this;
+        }
+
         ++this->active();
         if (tree_iterator_t {} == this->active())
         {
@@ -1650,7 +2163,7 @@ namespace idril
     auto brodal_queue_iterator<T, Compare, Allocator, IsConst>::operator*
         () const -> reference
     {
-        return **this->active();
+        return **this->current();
     }
 
     template<class T, class Compare, class Allocator, bool IsConst>
@@ -1665,7 +2178,8 @@ namespace idril
         (brodal_queue_iterator const& rhs) const -> bool
     {
         return T1Iterator_ == rhs.T1Iterator_
-            && T2Iterator_ == rhs.T2Iterator_;
+            && T2Iterator_ == rhs.T2Iterator_
+            && small_      == rhs.small_;
     }
 
     template<class T, class Compare, class Allocator, bool IsConst>
@@ -1679,7 +2193,7 @@ namespace idril
     auto brodal_queue_iterator<T, Compare, Allocator, IsConst>::current
         () const -> node_t* 
     {
-        return this->active().current();
+        return small_ ? *small_ : this->active().current();
     }
 
     template<class T, class Compare, class Allocator, bool IsConst>
@@ -1735,37 +2249,45 @@ namespace idril
 
 // root_wrap definition:
 
-    template<class Tree, class T, class Compare, class Allocator>
-    root_wrap<Tree, T, Compare, Allocator>::root_wrap
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    root_wrap<Tree, T, Compare, Allocator, Policy>::root_wrap
         (queue_t* const queue) :
         queue_ {queue}
     {
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    root_wrap<Tree, T, Compare, Allocator>::root_wrap
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    root_wrap<Tree, T, Compare, Allocator, Policy>::root_wrap
         (queue_t* queue, root_wrap const& other) :
         queue_ {queue},
+        sons_  {other.sons_},
         upper_ {up_reducer_t {this}, other.upper_},
-        lower_ {low_reducer_t {this}, other.lower_},
-        sons_  {other.sons_}
+        lower_ {low_reducer_t {this}, other.lower_}
     {
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    root_wrap<Tree, T, Compare, Allocator>::root_wrap
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    root_wrap<Tree, T, Compare, Allocator, Policy>::root_wrap
         (queue_t* queue, root_wrap&& other) noexcept:
         queue_ {queue},
         root_  {std::exchange(other.root_, nullptr)},
+        sons_  {std::move(other.sons_)},
         upper_ {up_reducer_t {this}, std::move(other.upper_)},
-        lower_ {low_reducer_t {this}, std::move(other.lower_)},
-        sons_  {std::move(other.sons_)}
+        lower_ {low_reducer_t {this}, std::move(other.lower_)}
     {
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::operator=
+        (root_wrap&& other) -> root_wrap&
+    {
+        // Implicit move assignment would also take queue pointer of the other wrap.
+        return this->template operator=<Tree>(std::move(other));
+    }
+
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
     template<class AnyTree>
-    auto root_wrap<Tree, T, Compare, Allocator>::operator=
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::operator=
         (any_wrap_t<AnyTree>&& other) -> root_wrap&
     {
         root_ = other.root_;
@@ -1787,22 +2309,22 @@ namespace idril
         return *this;
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::add_child
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::add_child
         (node_t* const child) -> void
     {
         return static_cast<Tree*>(this)->add_child(child);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::remove_child
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::remove_child
         (node_t* const child) -> void
     {
         return static_cast<Tree*>(this)->remove_child(child);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::add_child_base
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::add_child_base
         (node_t* const child) -> void
     {
         if (child->is_in_set())
@@ -1813,8 +2335,8 @@ namespace idril
         sons_[child->rank_]->add_right_sibling(child);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::add_delinked_nodes
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::add_delinked_nodes
         (delinked_nodes<T, Compare, Allocator> const& nodes) -> void
     {
         this->add_child(nodes.first);
@@ -1825,8 +2347,8 @@ namespace idril
         }
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::add_delinked_nodes_checked
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::add_delinked_nodes_checked
         (delinked_nodes<T, Compare, Allocator> const& nodes) -> void
     {
         this->add_child_checked(nodes.first);
@@ -1837,8 +2359,8 @@ namespace idril
         }
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::remove_child_base
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::remove_child_base
         (node_t* const child) -> void
     {
         if (sons_[child->rank_] == child)
@@ -1849,23 +2371,23 @@ namespace idril
         root_->remove_child(child);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::add_child_checked
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::add_child_checked
         (node_t* const child) -> void
     {
         this->add_child(child);
         this->upper_check(child->rank_);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::release_root
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::release_root
         () -> node_t*
     {
         return std::exchange(root_, nullptr);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::upper_check
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::upper_check
         (rank_t const rank) -> void
     {
         if (root_->rank_ > 2 && rank < root_->rank_ - 2)
@@ -1877,8 +2399,8 @@ namespace idril
         this->upper_check_n_minus_1();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::lower_check
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::lower_check
         (rank_t const rank) -> void
     {
         if (root_->rank_ > 2 && rank < root_->rank_ - 2)
@@ -1890,38 +2412,38 @@ namespace idril
         this->lower_check_n_minus_1();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::reduce_upper
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::reduce_upper
         (rank_t const rank) -> void
     {
         this->add_child(this->link_children(rank));
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::reduce_lower
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::reduce_lower
         (rank_t const rank) -> void
     {
         auto const delinked = this->delink_child(rank + 1);
         this->add_delinked_nodes(delinked);
-        queue_->extraNodes_.push(delinked.extra);
+        queue_->extraNodes_.push_back(delinked.extra);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::increase_rank
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::increase_rank
         (node_t* const n1, node_t* const n2) -> void
     {
         static_cast<Tree*>(this)->increase_rank(n1, n2);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::decrease_rank
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::decrease_rank
         () -> void
     {
         static_cast<Tree*>(this)->decrease_rank();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::increase_rank_base
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::increase_rank_base
         (node_t* const n1, node_t* const n2) -> void
     {
         root_->add_child(n1);
@@ -1929,29 +2451,29 @@ namespace idril
         sons_.push_back(n2);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::decrease_rank_base
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::decrease_rank_base
         () -> void
     {
         sons_.pop_back();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::increase_domain
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::increase_domain
         () -> void
     {
         static_cast<Tree*>(this)->increase_domain();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::decrease_domain
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::decrease_domain
         () -> void
     {
         static_cast<Tree*>(this)->decrease_domain();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::increase_domain_base
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::increase_domain_base
         () -> void
     {
         if (root_->rank_ < 3)
@@ -1963,8 +2485,8 @@ namespace idril
         lower_.increase_domain();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::decrease_domain_base() -> void
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::decrease_domain_base() -> void
     {
         if (root_->rank_ < 3)
         {
@@ -1975,8 +2497,8 @@ namespace idril
         lower_.decrease_domain();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::upper_check_n_minus_1
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::upper_check_n_minus_1
         () -> void
     {
         auto const rank = static_cast<rank_t>(root_->rank_ - 1);
@@ -1999,10 +2521,15 @@ namespace idril
 
         this->increase_rank(firstLinekd, secondLinked);
         this->increase_domain();
+
+        // Reduction at the top of the lower guide might have
+        // delinked a son of rank (n - 2) which is not covered by it.
+        this->lower_check_n_minus_2(2);
+        this->lower_check_n_minus_1();
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::upper_check_n_minus_2
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::upper_check_n_minus_2
         () -> void
     {
         if (root_->rank_ < 2)
@@ -2021,8 +2548,49 @@ namespace idril
         this->reduce_upper(rank);
     }
     
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::lower_check_n_minus_1
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::reduce_all_sons
+        () -> void
+    {
+        // Sons were added without upper checks. Ranks below (n - 2)
+        // are reduced to at most 6 sons so that the upper guide
+        // holds no num greater than 1 and can drop its blocks.
+        // Rank (n - 1) might then increase the rank of the root.
+        for (;;)
+        {
+            auto const n = root_->rank_;
+            for (auto rank = rank_t {0}; rank + 2 < n; ++rank)
+            {
+                auto count = node_t::same_rank_count(sons_[rank]);
+                while (count > 6)
+                {
+                    this->reduce_upper(rank);
+                    count -= 3;
+                }
+            }
+
+            if (n >= 2)
+            {
+                auto const rank = static_cast<rank_t>(n - 2);
+                while (node_t::same_rank_count(sons_[rank]) > 7)
+                {
+                    this->reduce_upper(rank);
+                }
+            }
+
+            upper_.reset();
+
+            if (node_t::same_rank_count(sons_[n - 1]) <= 7)
+            {
+                return;
+            }
+
+            this->upper_check_n_minus_1();
+        }
+    }
+
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::lower_check_n_minus_1
         () -> void
     {
         auto const rank  = static_cast<rank_t>(root_->rank_ - 1);
@@ -2058,7 +2626,7 @@ namespace idril
             node->remove_child(n1);
             node->remove_child(n2);
             node->remove_child(n3);
-            auto const linked = node_t::link_nodes(n1, n2, n3);
+            auto const linked = node_t::link_nodes(n1, n2, n3, queue_->compare_);
             this->add_child(linked);
             return;
         }
@@ -2078,8 +2646,8 @@ namespace idril
         this->add_child_checked(node);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::lower_check_n_minus_2
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::lower_check_n_minus_2
         (num_t const bound) -> num_t
     {
         if (root_->rank_ < 2)
@@ -2108,8 +2676,8 @@ namespace idril
         return extraRank != rank + 1 ? 1 : 0;
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::link_children
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::link_children
         (rank_t const rank) -> node_t*
     {
         auto const n1 = sons_[rank];
@@ -2120,11 +2688,11 @@ namespace idril
         this->remove_child(n2);
         this->remove_child(n1);
 
-        return node_t::link_nodes(n1, n2, n3);
+        return node_t::link_nodes(n1, n2, n3, queue_->compare_);
     } 
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::delink_child
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::delink_child
         (rank_t const rank) -> delinked_t
     {
         auto const toDelink = sons_[rank];
@@ -2132,8 +2700,8 @@ namespace idril
         return node_t::delink_node(toDelink);
     }
 
-    template<class Tree, class T, class Compare, class Allocator>
-    auto root_wrap<Tree, T, Compare, Allocator>::swap
+    template<class Tree, class T, class Compare, class Allocator, class Policy>
+    auto root_wrap<Tree, T, Compare, Allocator, Policy>::swap
         (root_wrap& rhs) noexcept -> void
     {
         using std::swap;
@@ -2145,15 +2713,15 @@ namespace idril
 
 // t1_wrap definition:
 
-    template<class T, class Compare, class Allocator>
-    t1_wrap<T, Compare, Allocator>::t1_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t1_wrap<T, Compare, Allocator, Policy>::t1_wrap
         (queue_t* const queue) :
         base_t {queue}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    t1_wrap<T, Compare, Allocator>::t1_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t1_wrap<T, Compare, Allocator, Policy>::t1_wrap
         (queue_t* const queue, t1_wrap const& other) :
         base_t     {queue, other},
         violation_ {viol_reducer_t {this}, other.violation_},
@@ -2161,8 +2729,8 @@ namespace idril
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    t1_wrap<T, Compare, Allocator>::t1_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t1_wrap<T, Compare, Allocator, Policy>::t1_wrap
         (queue_t* const queue, t1_wrap&& other) noexcept :
         base_t     {queue, std::move(other)},
         violation_ {viol_reducer_t {this}, std::move(other.violation_)},
@@ -2170,8 +2738,8 @@ namespace idril
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::operator=
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::operator=
         (t1_wrap&& other) -> t1_wrap&
     {
         base_t::operator=(std::move(other));
@@ -2182,22 +2750,22 @@ namespace idril
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::add_child
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::add_child
         (node_t* const child) -> void
     {
         base_t::add_child_base(child);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::remove_child
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::remove_child
         (node_t* const child) -> void
     {
         base_t::remove_child_base(child);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::add_violation
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::add_violation
         (node_t* const node) -> void
     {
         if (node->is_in_set())
@@ -2207,37 +2775,53 @@ namespace idril
 
         if (node->rank_ >= base_t::root_->rank_)
         {
-            base_t::root_->add_to_V(node);
+            base_t::root_->add_to_V(node, base_t::queue_->links_);
         }
-        else if (auxW_[node->rank_])
+        else if (this->first_violation(node->rank_))
         {
-            auxW_[node->rank_]->add_set_sibling(node);
+            auxW_[node->rank_]->add_set_sibling(node, base_t::queue_->links_);
+            node->listedRank_ = node->rank_;
         }
         else
         {
             auxW_[node->rank_] = node;
-            base_t::root_->add_to_W(node);
+            base_t::root_->add_to_W(node, base_t::queue_->links_);
+            node->listedRank_ = node->rank_;
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::remove_violation
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::remove_violation
         (node_t* const node) -> void
     {
-        if (node->rank_ < auxW_.size())
+        // Node might be listed under its previous rank.
+        auto const rank = node->listedRank_;
+        if (rank < auxW_.size() and auxW_[rank] == node)
         {
-            if (auxW_[node->rank_] == node)
-            {
-                node_t* const next {node->nextInSet_};
-                auxW_[node->rank_] = (next and next->rank_ == node->rank_ ? next : nullptr);
-            }
+            node_t* const next {node->next_in_set()};
+            auto const takesOver = next
+                               and next->rank_ == rank
+                               and next->listedRank_ == rank;
+            auxW_[rank] = takesOver ? next : nullptr;
         }
 
-        node_t::remove_from_set(node);
+        node_t::remove_from_set(node, base_t::queue_->links_);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::violation_check
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::first_violation
+        (rank_t const rank) -> node_t*
+    {
+        if (auxW_[rank] && auxW_[rank]->rank_ != rank)
+        {
+            auxW_[rank] = nullptr;
+        }
+
+        return auxW_[rank];
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::violation_check
         (rank_t const rank) -> void
     {
         if (rank < auxW_.size())
@@ -2246,8 +2830,8 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::reduce_violation
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::reduce_violation
         (rank_t const rank) -> void
     {
         auto removed = num_t {0};
@@ -2257,28 +2841,26 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::reduce_all_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::reduce_all_violations
         () -> void
     {
-        for (auto const node : auxW_)
+        // Reductions can take other violations of the same rank out
+        // of the set e.g. by delinking their parent so they are
+        // counted again after each of them.
+        for (auto rank = rank_t {0}; rank < auxW_.size(); ++rank)
         {
-            if (!node)
-            {
-                continue;
-            }
-
-            auto const rank = node->rank_;
-            auto count      = node_t::same_rank_violation(node);
-            while (count > 1)
+            auto node = this->first_violation(rank);
+            while (node and node_t::same_rank_violation(node) > 1)
             {
-                count -= this->reduce_violations(rank);
+                this->reduce_violations(rank);
+                node = this->first_violation(rank);
             }
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::increase_rank
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::increase_rank
         (node_t* const linked) -> void
     {
         node_t* const n1    {linked};
@@ -2288,45 +2870,50 @@ namespace idril
         this->increase_rank(n1->disconnect(), n2->disconnect());
         this->increase_domain();
 
-        node_t::fold_right(extra, [=](node_t* const n) {
+        node_t::fold_right(extra, [this](node_t* const n) {
             this->add_child_checked(n->disconnect());
         });
+
+        // Reduction at the top of the lower guide might have
+        // delinked a son of rank (n - 2) which is not covered by it.
+        this->lower_check_n_minus_2(2);
+        this->lower_check_n_minus_1();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::increase_rank
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::increase_rank
         (node_t* const n1, node_t* const n2) -> void
     {
         base_t::increase_rank_base(n1, n2);
         auxW_.push_back(nullptr);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::decrease_rank
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::decrease_rank
         () -> void
     {
         base_t::decrease_rank_base();
         auxW_.pop_back();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::increase_domain
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::increase_domain
         () -> void
     {
         base_t::increase_domain_base();
         violation_.increase_domain();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::decrease_domain
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::decrease_domain
         () -> void
     {
         base_t::decrease_domain_base();
         violation_.decrease_domain();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::reduce_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::reduce_violations
         (rank_t const rank) -> num_t
     {
         auto const normal = this->pick_normal_violations(rank);
@@ -2344,11 +2931,11 @@ namespace idril
         return this->remove_normal_violations(normal.first, normal.second);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::pick_normal_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::pick_normal_violations
         (rank_t const rank) -> node_ptr_pair
     {
-        auto it     = auxW_[rank];
+        auto it     = this->first_violation(rank);
         auto first  = static_cast<node_t*>(nullptr);
         auto second = static_cast<node_t*>(nullptr);
 
@@ -2361,24 +2948,26 @@ namespace idril
                 else return std::make_pair(first, second);
             }
             
-            it = it->nextInSet_;
+            it = it->next_in_set();
         }
 
         return std::make_pair(first, second);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::pick_t2_son_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::pick_t2_son_violations
         (rank_t const rank) -> node_ptr_pair
     {
         auto count = num_t {0};
-        auto it     = auxW_[rank];
+        auto it     = this->first_violation(rank);
         auto first  = static_cast<node_t*>(nullptr);
         auto second = static_cast<node_t*>(nullptr);
 
         while (it && it->rank_ == rank)
         {
-            if (it->is_son_of_root())
+            // Sons of t1 might be in the set too e.g. after meld
+            // so only sons actually hanging under t2 are counted.
+            if (it->parent_ == base_t::queue_->T2_.root_ && it->is_violating(base_t::queue_->compare_))
             {
                 count++;
                 if (count > 4)
@@ -2388,14 +2977,14 @@ namespace idril
                 }
             }
             
-            it = it->nextInSet_;
+            it = it->next_in_set();
         }
 
         return std::make_pair(first, second);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::remove_t2_violation
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::remove_t2_violation
         (node_t* const node) -> num_t
     {
         if (!node)
@@ -2403,7 +2992,7 @@ namespace idril
             return 0;
         }
 
-        if (!node->is_violating())
+        if (!node->is_violating(base_t::queue_->compare_))
         {
             this->remove_violation(node);
             return 1;
@@ -2419,14 +3008,14 @@ namespace idril
         return 1;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::remove_normal_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::remove_normal_violations
         (node_t* const first, node_t* const second) -> num_t
     {
         auto const n1 = first;
         auto const n2 = second ? second : n1->same_rank_sibling();
 
-        if (!n1->is_violating())
+        if (!n1->is_violating(base_t::queue_->compare_))
         {
             this->remove_violation(n1);
             return 1;
@@ -2436,7 +3025,7 @@ namespace idril
 
         if (!node_t::are_siblings(n1, n2))
         {
-            node_t::make_siblings(n1, n2);
+            node_t::make_siblings(n1, n2, base_t::queue_->compare_);
         }
 
         auto const siblingCount = node_t::same_rank_count(n1);
@@ -2455,7 +3044,7 @@ namespace idril
             {
                 auto const replacement = base_t::sons_[parent->rank_]->right_;
                 node_t::swap_tree_nodes(parent, replacement);
-                if (replacement->is_violating())
+                if (replacement->is_violating(base_t::queue_->compare_))
                 {
                     this->add_violation(replacement);
                 }
@@ -2484,8 +3073,8 @@ namespace idril
         return removed;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t1_wrap<T, Compare, Allocator>::swap
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t1_wrap<T, Compare, Allocator, Policy>::swap
         (t1_wrap& rhs) noexcept -> void
     {
         using std::swap;
@@ -2494,66 +3083,66 @@ namespace idril
         swap(violation_, rhs.violation_);
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     auto swap
-        ( t1_wrap<T, Compare, Allocator>& lhs
-        , t1_wrap<T, Compare, Allocator>& rhs ) noexcept -> void
+        ( t1_wrap<T, Compare, Allocator, Policy>& lhs
+        , t1_wrap<T, Compare, Allocator, Policy>& rhs ) noexcept -> void
     {
         lhs.swap(rhs);
     }
 
 // t2_wrap definition:
 
-    template<class T, class Compare, class Allocator>
-    t2_wrap<T, Compare, Allocator>::t2_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t2_wrap<T, Compare, Allocator, Policy>::t2_wrap
         (queue_t* const queue) :
         base_t {queue}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    t2_wrap<T, Compare, Allocator>::t2_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t2_wrap<T, Compare, Allocator, Policy>::t2_wrap
         (queue_t* const queue, t2_wrap const& other) :
         base_t {queue, other}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    t2_wrap<T, Compare, Allocator>::t2_wrap
+    template<class T, class Compare, class Allocator, class Policy>
+    t2_wrap<T, Compare, Allocator, Policy>::t2_wrap
         (queue_t* const queue, t2_wrap&& other) noexcept :
         base_t {queue, std::move(other)}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::operator=
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::operator=
         (t1_wrap_t&& other) -> t2_wrap&
     {
         base_t::operator=(std::move(other));
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::operator=
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::operator=
         (t2_wrap&& other) -> t2_wrap&
     {
         base_t::operator=(std::move(other));
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::add_child
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::add_child
         (node_t* const child) -> void
     {
         base_t::add_child_base(child);
-        if (child->is_violating())
+        if (child->is_violating(base_t::queue_->compare_))
         {
-            base_t::queue_->violations_.push(child);
+            base_t::queue_->violations_.push_back(child);
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::remove_child
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::remove_child
         (node_t* const child) -> void
     {
         if (child->is_in_set())
@@ -2564,36 +3153,36 @@ namespace idril
         base_t::remove_child_base(child);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::increase_rank
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::increase_rank
         (node_t* const n1, node_t* const n2) -> void
     {
         base_t::increase_rank_base(n1, n2);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::decrease_rank
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::decrease_rank
         () -> void
     {
         base_t::decrease_rank_base();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::increase_domain
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::increase_domain
         () -> void
     {
         base_t::increase_domain_base();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::decrease_domain
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::decrease_domain
         () -> void
     {
         base_t::decrease_domain_base();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::removeLargeSons
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::removeLargeSons
         () -> node_t*
     {
         auto const newRootsRank = static_cast<rank_t>(base_t::root_->rank_ - 1);
@@ -2612,7 +3201,7 @@ namespace idril
             base_t::root_->set_rank();
         }
 
-        node_t::fold_right(ret, [=](auto const n)
+        node_t::fold_right(ret, [this](auto const n)
         {
             if (n->is_in_set())
             {
@@ -2623,24 +3212,24 @@ namespace idril
         return ret;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::swap
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::swap
         (t2_wrap& rhs) noexcept -> void
     {
         base_t::swap(rhs);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto t2_wrap<T, Compare, Allocator>::swap
+    template<class T, class Compare, class Allocator, class Policy>
+    auto t2_wrap<T, Compare, Allocator, Policy>::swap
         (t1_wrap_t& rhs) noexcept -> void
     {
         base_t::swap(rhs);
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     auto swap
-        ( t2_wrap<T, Compare, Allocator>& lhs
-        , t2_wrap<T, Compare, Allocator>& rhs ) noexcept -> void
+        ( t2_wrap<T, Compare, Allocator, Policy>& lhs
+        , t2_wrap<T, Compare, Allocator, Policy>& rhs ) noexcept -> void
     {
         lhs.swap(rhs);
     }
@@ -2713,102 +3302,203 @@ namespace idril
     auto violation_reducer<Reducible, T, Compare, Allocator>::get_num
         (index_t const i) const -> num_t
     {
-        if (!managedRoot_->auxW_[i]) 
+        auto const first = managedRoot_->first_violation(i);
+        if (!first)
         {
             return 0;
         }
 
-        auto const count = node_t::same_rank_violation(managedRoot_->auxW_[i]);
+        auto const count = node_t::same_rank_violation(first);
         return count < 5 ? 0 : count - 4;
     }
 
 // brodal_queue definition:
 
-    template<class T, class Compare, class Allocator>
-    brodal_queue<T, Compare, Allocator>::brodal_queue
+    template<class T, class Compare, class Allocator, class Policy>
+    brodal_queue<T, Compare, Allocator, Policy>::brodal_queue
         (Allocator const& alloc) :
+        brodal_queue    {Compare(), alloc}
+    {
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    brodal_queue<T, Compare, Allocator, Policy>::brodal_queue
+        (Compare const& compare, Allocator const& alloc) :
         size_           {0},
+        smallSize_      {SMALL_SIZE},
+        deferredSons_       {0},
+        deferredViolations_ {0},
+        compare_        {compare},
         T1_             {this},
         T2_             {this},
-        nodeAllocator_  {alloc},
-        entryAllocator_ {alloc}
+        nodes_          {alloc},
+        entries_        {alloc},
+        links_          {alloc},
+        small_          {}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    brodal_queue<T, Compare, Allocator>::brodal_queue
+    template<class T, class Compare, class Allocator, class Policy>
+    brodal_queue<T, Compare, Allocator, Policy>::brodal_queue
         (brodal_queue const& other) :
         size_           {other.size_},
+        smallSize_      {other.smallSize_},
+        deferredSons_       {other.deferredSons_},
+        deferredViolations_ {other.deferredViolations_},
+        compare_        {other.compare_},
         T1_             {this, other.T1_},
         T2_             {this, other.T2_},
-        nodeAllocator_  {other.nodeAllocator_},
-        entryAllocator_ {other.entryAllocator_}
+        nodes_          {other.nodes_.get_allocator()},
+        entries_        {other.nodes_.get_allocator()},
+        links_          {other.nodes_.get_allocator()},
+        small_          {}
     {
-        auto const map = this->shallow_copy_nodes(other);
-        this->deep_copy_tree(map);
-        this->deep_copy_violations(map);
-        this->deep_copy_wraps(other, map);
+        if (other.is_small())
+        {
+            // Copies keep their index in the array heap.
+            std::transform( std::begin(other.small_), std::begin(other.small_) + size_
+                          , std::begin(small_), [this](auto const n)
+            {
+                return this->shallow_copy_node(n);
+            });
+            return;
+        }
+
+        auto linked = node_pairs {};
+        T1_.root_ = this->deep_copy_tree(other.T1_.root_, linked);
+        T2_.root_ = this->deep_copy_tree(other.T2_.root_, linked);
+        this->deep_copy_violations(linked);
+        this->deep_copy_wraps(linked);
     }
 
-    template<class T, class Compare, class Allocator>
-    brodal_queue<T, Compare, Allocator>::brodal_queue
+    template<class T, class Compare, class Allocator, class Policy>
+    template<std::input_iterator InputIt>
+    brodal_queue<T, Compare, Allocator, Policy>::brodal_queue
+        (InputIt first, InputIt last, Compare const& compare, Allocator const& alloc) :
+        brodal_queue {compare, alloc}
+    {
+        auto nodes = node_stack_t {};
+        if constexpr (std::forward_iterator<InputIt>)
+        {
+            auto const count = static_cast<size_type>(std::distance(first, last));
+            nodes.reserve(count);
+            entries_.reserve(count);
+            nodes_.reserve(count);
+        }
+
+        try
+        {
+            for (; first != last; ++first)
+            {
+                nodes.push_back(this->new_node(*first));
+            }
+        }
+        catch (...)
+        {
+            // Nodes are not in the queue yet so its destructor misses them.
+            for (auto const node : nodes)
+            {
+                this->delete_node(node);
+            }
+            throw;
+        }
+
+        this->build(nodes);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    brodal_queue<T, Compare, Allocator, Policy>::brodal_queue
         (brodal_queue&& other) noexcept :
         size_           {std::exchange(other.size_, 0)},
+        smallSize_      {other.smallSize_},
+        deferredSons_       {std::exchange(other.deferredSons_, 0)},
+        deferredViolations_ {std::exchange(other.deferredViolations_, 0)},
+        compare_        {other.compare_},
         T1_             {this, std::move(other.T1_)},
         T2_             {this, std::move(other.T2_)},
-        nodeAllocator_  {std::move(other.nodeAllocator_)},
-        entryAllocator_ {std::move(other.entryAllocator_)}
+        nodes_          {std::move(other.nodes_)},
+        entries_        {std::move(other.entries_)},
+        links_          {std::move(other.links_)},
+        small_          {other.small_}
     {
     }
 
-    template<class T, class Compare, class Allocator>
-    brodal_queue<T, Compare, Allocator>::~brodal_queue
+    template<class T, class Compare, class Allocator, class Policy>
+    brodal_queue<T, Compare, Allocator, Policy>::~brodal_queue
         ()
     {
-        auto it  = this->begin();
-        auto end = this->end();
-
-        while (it != end)
+        // Slabs release the memory, nodes only need to be destroyed.
+        if constexpr (not std::is_trivially_destructible_v<node_t>)
         {
-            this->delete_node(it.current());
-            ++it;
+            if (this->is_small())
+            {
+                std::for_each_n(std::begin(small_), size_, [this](auto const n)
+                {
+                    this->delete_node(n);
+                });
+            }
+            else
+            {
+                this->delete_tree(T1_.root_);
+                this->delete_tree(T2_.root_);
+            }
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::operator=
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::operator=
         (brodal_queue rhs) -> brodal_queue&
     {
         this->swap(rhs);
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     template<class... Args>
-    auto brodal_queue<T, Compare, Allocator>::emplace
+    auto brodal_queue<T, Compare, Allocator, Policy>::emplace
         (Args&&... args) -> handle_t
     {
         return this->insert_impl(this->new_node(std::forward<Args>(args)...));
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::insert
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert
         (value_type const& value) -> handle_t
     {
         return this->insert_impl(this->new_node(value));
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::insert
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert
         (value_type&& value) -> handle_t
     {
         return this->insert_impl(this->new_node(std::move(value)));
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::delete_min
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delete_min
+        () -> void
+    {
+        if (this->is_small())
+        {
+            this->erase_small_impl(small_[0]);
+            return;
+        }
+
+        this->delete_min_impl();
+
+        if (size_ <= smallSize_ / 2)
+        {
+            this->demote();
+        }
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delete_min_impl
         () -> void
     {
+        this->repair();
+
         if (this->size() < 4)
         {
             this->delete_min_special();
@@ -2846,67 +3536,92 @@ namespace idril
         --size_;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::find_min
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::find_min
         () -> reference
     {
         this->is_empty_check();
+        if (this->is_small())
+        {
+            return **small_[0];
+        }
+
         this->move_to_T1();
         return **T1_.root_;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::find_min
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::find_min
         () const -> const_reference
     {
         this->is_empty_check();
-        return **T1_.root_;
+        return this->is_small() ? **small_[0] : **T1_.root_;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::decrease_key
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::decrease_key
         (handle_t const handle) -> void
     {
         this->dec_key_impl(handle.entry_->node_);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::decrease_key
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::decrease_key
         (iterator pos) -> void
     {
         this->dec_key_impl(pos.current());
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::decrease_key
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::decrease_key
         (const_iterator pos) -> void
     {
         this->dec_key_impl(pos.current());
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::meld
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::meld
         (brodal_queue rhs) -> brodal_queue&
     {
         // First we solve some special cases.
-        if (rhs.size() < 4)
+        // Small queues are inserted node by node.
+        if (rhs.size() < 4 or rhs.is_small())
         {
             return this->swallow(rhs);
         }
 
-        if (this->empty())
+        if (this->size() < 4 or this->is_small())
         {
             this->swap(rhs);
-            return *this;
+            return this->swallow(rhs);
         }
 
+        // Both queues must satisfy the invariants before they are combined.
+        this->repair();
+        rhs.repair();
+
         // Here we make sure that this->T1 has the highest priority.
-        if (*rhs.T1_.root_ < *T1_.root_)
+        if (compare_(**rhs.T1_.root_, **T1_.root_))
         {
             this->swap(rhs);
         }
-        
-        size_ += rhs.size_;
+
+        // Handles of the other queue point to its entries.
+        nodes_.splice(rhs.nodes_);
+        entries_.splice(rhs.entries_);
+        links_.splice(rhs.links_);
+        size_ += std::exchange(rhs.size_, 0);
+
+        // Violations of the other t1 must be tracked by this t1.
+        node_t::fold_next(rhs.T1_.root_->first_in_W(), [this](auto const n)
+        {
+            violations_.push_back(n);
+        });
+
+        node_t::fold_next(rhs.T1_.root_->first_in_V(), [this](auto const n)
+        {
+            violations_.push_back(n);
+        });
 
         // If there is this->T2 it certainly has higher rank than this->T1.
         // However other trees might not so we try to add them under t1 if possible.
@@ -2921,169 +3636,263 @@ namespace idril
         this->add_under_t2(rhs.T1_.root_);
         this->add_under_t2(rhs.T2_.root_);
 
+        this->add_extra_nodes();
+        this->add_violations();
+
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::erase
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::erase
         (handle_t const handle) -> void
     {
         this->erase_impl(handle.entry_->node_);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::erase
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::erase
         (iterator pos) -> void
     {
         this->erase_impl(pos.current());
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::erase
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::erase
         (const_iterator pos) -> void
     {
         this->erase_impl(pos.current());
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::swap
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::swap
         (brodal_queue& rhs) noexcept -> void
     {
         using std::swap;
-        swap(size_, rhs.size_);
-        swap(T1_,   rhs.T1_);
-        swap(T2_,   rhs.T2_);
-
-        if constexpr (node_alloc_traits::propagate_on_container_swap::value)
-        {
-            swap(nodeAllocator_, rhs.nodeAllocator_);
-        }
-
-        if constexpr (entry_alloc_traits::propagate_on_container_swap::value)
-        {
-            swap(entryAllocator_, rhs.entryAllocator_);
-        }
-    }
-
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::size
+        swap(size_,      rhs.size_);
+        swap(smallSize_, rhs.smallSize_);
+        swap(deferredSons_,       rhs.deferredSons_);
+        swap(deferredViolations_, rhs.deferredViolations_);
+        swap(compare_,   rhs.compare_);
+        swap(small_,     rhs.small_);
+        swap(T1_,        rhs.T1_);
+        swap(T2_,        rhs.T2_);
+        nodes_.swap(rhs.nodes_);
+        entries_.swap(rhs.entries_);
+        links_.swap(rhs.links_);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::size
         () const -> size_type
     {
         return size_;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::max_size
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::max_size
         () const -> size_type
     {
         return std::numeric_limits<size_type>::max();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::empty
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::empty
         () const -> bool
     {
         return 0 == this->size();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::clear
-        () -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::small_size
+        () const -> size_type
     {
-        *this = brodal_queue {};
+        return smallSize_;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::begin
-        () -> iterator
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::small_size
+        (size_type const size) -> void
     {
-        return iterator {T1_.root_, T2_.root_};
+        smallSize_ = std::min(size, SMALL_CAPACITY);
+        if (this->is_small() and size_ > smallSize_)
+        {
+            this->promote();
+        }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::end() -> iterator
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::clear
+        () -> void
+    {
+        auto empty = brodal_queue {compare_, nodes_.get_allocator()};
+        empty.smallSize_ = smallSize_;
+        *this = std::move(empty);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    template<class OutputIt>
+    auto brodal_queue<T, Compare, Allocator, Policy>::pop_n
+        (size_type k, OutputIt out) -> OutputIt
+    {
+        k = std::min(k, size_);
+        if (not this->is_small() and k > size_ / POP_REBUILD_RATIO)
+        {
+            return this->pop_n_rebuild(k, out);
+        }
+
+        for (; k > 0; --k)
+        {
+            *out = std::move(this->find_min());
+            ++out;
+            this->delete_min();
+        }
+
+        return out;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::begin
+        () -> iterator
+    {
+        return this->is_small()
+            ? iterator {small_.data(), small_.data() + size_}
+            : iterator {T1_.root_, T2_.root_};
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::end() -> iterator
     {
         return iterator {};
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::begin
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::begin
         () const -> const_iterator
     {
-        return const_iterator {T1_.root_, T2_.root_};
+        return this->is_small()
+            ? const_iterator {small_.data(), small_.data() + size_}
+            : const_iterator {T1_.root_, T2_.root_};
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::end
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::end
         () const -> const_iterator
     {
         return const_iterator {};
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::cbegin
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::cbegin
         () const -> const_iterator
     {
         return const_cast<brodal_queue const*>(this)->begin();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::cend
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::cend
         () const -> const_iterator
     {
         return const_cast<brodal_queue const*>(this)->end();
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     template<class... Args>
-    auto brodal_queue<T, Compare, Allocator>::new_node
+    auto brodal_queue<T, Compare, Allocator, Policy>::new_node
         (Args&&... args) -> node_t*
     {
-        auto const entry = this->new_entry(std::forward<Args>(args)...) ;
-        auto const node  = node_alloc_traits::allocate(nodeAllocator_, 1);
-        node_alloc_traits::construct(nodeAllocator_, node, entry);
-        return node;
+        auto const entry = entries_.create();
+        try
+        {
+            return nodes_.create(entry, std::in_place, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            entries_.destroy(entry);
+            throw;
+        }
     }
 
-    template<class T, class Compare, class Allocator>
-    template<class... Args>
-    auto brodal_queue<T, Compare, Allocator>::new_entry
-        (Args&&... args) -> entry_t*
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::shallow_copy_node
+        (node_t const* const node) -> node_t*
     {
-        auto entry = entry_alloc_traits::allocate(entryAllocator_, 1);
-        entry_alloc_traits::construct(entryAllocator_, entry, std::forward<Args>(args)...);
-        return entry;
+        auto const entry = entries_.create();
+        try
+        {
+            return nodes_.create(entry, *node);
+        }
+        catch (...)
+        {
+            entries_.destroy(entry);
+            throw;
+        }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::shallow_copy_node
-        (node_t* const node) -> node_t*
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delete_node
+        (node_t* const node) -> void
     {
-        auto const entry = this->new_entry(**node) ;
-        auto const cnode = node_alloc_traits::allocate(nodeAllocator_, 1);
-        node_alloc_traits::construct(nodeAllocator_, cnode, entry, *node);
-        return cnode;
+        if (node->setLinks_)
+        {
+            links_.destroy(node->setLinks_);
+        }
+        entries_.destroy(node->entry_);
+        nodes_.destroy(node);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::delete_node
-        (node_t* const node) -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delete_tree
+        (node_t* node) -> void
     {
-        this->delete_entry(node->entry_);
-        node_alloc_traits::destroy(nodeAllocator_, node);
-        node_alloc_traits::deallocate(nodeAllocator_, node, 1);
+        // Rotates sons into the sibling list so that every node
+        // is deleted once its sons have been moved out of it.
+        while (node)
+        {
+            if (auto const son = node->child_)
+            {
+                node->child_ = son->right_;
+                son->right_  = node;
+                node         = son;
+            }
+            else
+            {
+                auto const next = node->right_;
+                this->delete_node(node);
+                node = next;
+            }
+        }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::delete_entry
-        (entry_t* const entry) -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert_impl
+        (node_t* const node) -> handle_t
     {
-        entry_alloc_traits::destroy(entryAllocator_, entry);
-        entry_alloc_traits::deallocate(entryAllocator_, entry, 1);
+        if (this->is_small())
+        {
+            if (size_ < smallSize_)
+            {
+                return this->insert_small_impl(node);
+            }
+
+            this->promote();
+        }
+
+        return this->insert_tree_impl(node);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::insert_impl
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert_small_impl
+        (node_t* const node) -> handle_t
+    {
+        auto const i = static_cast<index_t>(size_);
+        small_[i] = node;
+        ++size_;
+        this->sift_up(i);
+        return handle_t(node->entry_);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert_tree_impl
         (node_t* const node) -> handle_t
     {
         if (this->size() < 3)
@@ -3095,20 +3904,27 @@ namespace idril
 
         ++size_;
 
-        if (*node < *T1_.root_)
+        if (compare_(**node, **T1_.root_))
         {
             node_t::swap_entries(node, T1_.root_);
         }
 
-        T1_.add_child_checked(node);
-
-        this->move_to_T1();
+        if constexpr (IS_RELAXED)
+        {
+            T1_.add_child(node);
+            this->defer(deferredSons_);
+        }
+        else
+        {
+            T1_.add_child_checked(node);
+            this->move_to_T1();
+        }
 
         return handle_t(entry);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::insert_special_impl
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::insert_special_impl
         (node_t* const node) -> handle_t
     {
         ++size_;
@@ -3120,7 +3936,7 @@ namespace idril
             T1_.root_ = node;
             return handle_t(entry);
         }
-        else if (*node < *T1_.root_)
+        else if (compare_(**node, **T1_.root_))
         {
             node_t::swap_entries(node, T1_.root_);
         }
@@ -3140,29 +3956,167 @@ namespace idril
         return handle_t(entry);
     }
 
-    template<class T, class Compare, class Allocator>
-    template<class Cmp>
-    auto brodal_queue<T, Compare, Allocator>::dec_key_impl
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::build
+        (node_stack_t& nodes) -> void
+    {
+        if (nodes.size() <= smallSize_)
+        {
+            for (auto const node : nodes)
+            {
+                this->insert_small_impl(node);
+            }
+            return;
+        }
+
+        // The smallest node becomes the root of t1. Other nodes of each
+        // rank are either its sons or linked by three into nodes of the
+        // next rank. Ranks below (n - 2) keep 4 to 6 sons and the top
+        // two ranks 2 to 7, so guides need no blocks and there are no
+        // violations.
+        auto const min = std::min_element(std::begin(nodes), std::end(nodes)
+                                         , [this](auto const l, auto const r)
+        {
+            return compare_(**l, **r);
+        });
+        std::iter_swap(std::begin(nodes), min);
+        T1_.root_ = nodes.front();
+        size_     = nodes.size();
+
+        auto const level = std::next(std::begin(nodes));
+        auto count       = nodes.size() - 1;
+        for (;;)
+        {
+            auto const keep = count <= 7 ? count
+                            : count <= 9 ? count - 6
+                                         : 4 + (count - 4) % 3;
+
+            T1_.increase_rank(level[0], level[1]);
+            std::for_each(level + 2, level + keep, [this](auto const n)
+            {
+                this->T1_.add_child(n);
+            });
+            T1_.increase_domain();
+
+            if (keep == count)
+            {
+                return;
+            }
+
+            auto out = level;
+            for (auto i = keep; i < count; i += 3)
+            {
+                *out++ = node_t::link_nodes(level[i], level[i + 1], level[i + 2], compare_);
+            }
+            count = (count - keep) / 3;
+        }
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    template<class OutputIt>
+    auto brodal_queue<T, Compare, Allocator, Policy>::pop_n_rebuild
+        (size_type const k, OutputIt out) -> OutputIt
+    {
+        // Nodes are collected before they are reset as in demote.
+        auto nodes = node_stack_t {};
+        nodes.reserve(size_);
+        for (auto it = std::begin(*this), end = std::end(*this); it != end; ++it)
+        {
+            nodes.push_back(it.current());
+        }
+
+        T1_                 = t1_wrap {this};
+        T2_                 = t2_wrap {this};
+        size_               = 0;
+        deferredSons_       = 0;
+        deferredViolations_ = 0;
+
+        for (auto const node : nodes)
+        {
+            node->reset(links_);
+        }
+
+        auto const less = [this](auto const l, auto const r)
+        {
+            return compare_(**l, **r);
+        };
+
+        auto const kth = std::next(std::begin(nodes), static_cast<std::ptrdiff_t>(k));
+        std::nth_element(std::begin(nodes), kth, std::end(nodes), less);
+        std::sort(std::begin(nodes), kth, less);
+        auto popped = node_stack_t(std::begin(nodes), kth);
+        nodes.erase(std::begin(nodes), kth);
+
+        // Rest of the queue is valid before any value is moved out.
+        this->build(nodes);
+
+        auto it = std::begin(popped);
+        try
+        {
+            for (; it != std::end(popped); ++it)
+            {
+                *out = std::move(***it);
+                ++out;
+                this->delete_node(*it);
+            }
+        }
+        catch (...)
+        {
+            std::for_each(it, std::end(popped), [this](auto const n)
+            {
+                this->delete_node(n);
+            });
+            throw;
+        }
+
+        return out;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::dec_key_impl
         (node_t* const node) -> void
     {
-        this->move_to_T1(); 
+        if (this->is_small())
+        {
+            this->sift_up(node->rank_);
+            return;
+        }
+
+        // Violations under a large t2 can be reduced only after it
+        // is partly moved under t1, so relaxed queues do it as well.
+        this->move_to_T1();
 
-        if (Cmp {} (**node, **T1_.root_))
+        if (compare_(**node, **T1_.root_))
         {
             node_t::swap_entries(node, T1_.root_);
         }
 
-        if (node->is_violating() and not node->is_in_set())
+        if (node->is_violating(compare_) and not node->is_in_set())
         {
+            // Violations can be reduced all at once only when there is
+            // no t2 so they are not deferred while there is one.
             T1_.add_violation(node);
-            T1_.violation_check(node->rank_);
+            if (IS_RELAXED and not T2_.root_)
+            {
+                this->defer(deferredViolations_);
+            }
+            else
+            {
+                T1_.violation_check(node->rank_);
+            }
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::erase_impl
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::erase_impl
         (node_t* const node) -> void
     {
+        if (this->is_small())
+        {
+            this->erase_small_impl(node);
+            return;
+        }
+
         node_t::swap_entries(node, T1_.root_);
 
         if (node->parent_ && T1_.root_ != node->parent_ && !node->is_in_set())
@@ -3176,8 +4130,25 @@ namespace idril
         this->delete_min();
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::delete_min_special
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::erase_small_impl
+        (node_t* const node) -> void
+    {
+        auto const i    = node->rank_;
+        auto const last = small_[--size_];
+        if (last != node)
+        {
+            small_[i]   = last;
+            last->rank_ = i;
+            this->sift_up(i);
+            this->sift_down(last->rank_);
+        }
+
+        this->delete_node(node);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delete_min_special
         () -> void
     {
         auto const oldRoot = T1_.root_;
@@ -3199,7 +4170,7 @@ namespace idril
             firstChild->disconnect();
             secondChild->disconnect();
 
-            if (*firstChild < *secondChild)
+            if (compare_(**firstChild, **secondChild))
             {
                 T1_.root_ = firstChild;
                 T2_.root_ = secondChild;
@@ -3218,9 +4189,9 @@ namespace idril
         --size_;
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     template<class RootWrap>
-    auto brodal_queue<T, Compare, Allocator>::pick_T2
+    auto brodal_queue<T, Compare, Allocator, Policy>::pick_T2
         (RootWrap& wrap) -> void
     {
         if (!wrap.root_)
@@ -3248,14 +4219,14 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::add_extra_nodes
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::add_extra_nodes
         () -> void
     {
         while (!extraNodes_.empty())
         {
-            auto const node = extraNodes_.top();
-            extraNodes_.pop();
+            auto const node = extraNodes_.back();
+            extraNodes_.pop_back();
             if (node->rank_ < T1_.root_->rank_)
             {
                 T1_.add_child_checked(node);
@@ -3267,21 +4238,21 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::add_violations
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::add_violations
         () -> void
     {
         while (!violations_.empty())
         {
-            auto const violation = violations_.top();
-            violations_.pop();
+            auto const violation = violations_.back();
+            violations_.pop_back();
             T1_.add_violation(violation);
             T1_.violation_check(violation->rank_);
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::is_empty_check
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::is_empty_check
         () -> void
     {
         if (this->empty())
@@ -3290,8 +4261,8 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::move_all_to_T1
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::move_all_to_T1
         () -> void
     {
         if (!T2_.root_)
@@ -3308,13 +4279,13 @@ namespace idril
         T2_ = t2_wrap {this};
 
         // Add sons with rank 0 under t1.
-        node_t::fold_right(rightFoldable, [=](auto const n)
+        node_t::fold_right(rightFoldable, [this](auto const n)
         {
             T1_.add_child_checked(n->disconnect());
         });
 
         // Add other sons with ranks > 0 under t1.
-        node_t::fold_left(leftFoldable, [=](auto const n)
+        node_t::fold_left(leftFoldable, [this](auto const n)
         {
             n->disconnect();
             
@@ -3331,8 +4302,8 @@ namespace idril
         T1_.add_child_checked(oldt2);
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::move_to_T1
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::move_to_T1
         () -> void
     {
         if (!T2_.root_ || this->size() < 4)
@@ -3340,22 +4311,54 @@ namespace idril
             return;
         }
 
-        if (T2_.root_->rank_ <= T1_.root_->rank_ + 2)
+        this->repair();
+
+        if (T2_.root_->rank_ <= T1_.root_->rank_)
+        {
+            // t1 might have outgrown t2 e.g. after meld
+            // so t2 can be simply added under t1.
+            auto const oldt2 = T2_.release_root();
+            T2_ = t2_wrap {this};
+            this->delink_under_t1(oldt2);
+            this->add_extra_nodes();
+            this->add_violations();
+        }
+        else if (T2_.root_->rank_ <= T1_.root_->rank_ + 2)
         {
             // r(t2) is (r(t1) + 1) or (r(t1) + 2)
+            // Adding sons might have increased rank of t1 by linking
+            // so the next sons are not necessarily of the same rank.
+            auto const add_sons = [this](node_t* const sons)
+            {
+                if (sons->rank_ == T1_.root_->rank_)
+                {
+                    T1_.increase_rank(sons);
+                }
+                else
+                {
+                    node_t::fold_right(sons, [this](auto const n)
+                    {
+                        this->delink_under_t1(n->disconnect());
+                    });
+                }
+            };
+
             auto const sons1 = T2_.removeLargeSons();
             if (T2_.root_->rank_ > T1_.root_->rank_)
             {
-                auto const sons2 = T2_.removeLargeSons();
-                T1_.increase_rank(sons2);
+                add_sons(T2_.removeLargeSons());
             }
-            T1_.increase_rank(sons1);
+            add_sons(sons1);
 
             auto const oldt2 = T2_.release_root();
-            T1_.add_child_checked(oldt2);
+            this->delink_under_t1(oldt2);
 
             // Reset t2 wrap to defaults. 
             T2_ = t2_wrap {this};
+
+            // Linking under t1 might have delinked some nodes.
+            this->add_extra_nodes();
+            this->add_violations();
         }
         else
         {
@@ -3367,19 +4370,15 @@ namespace idril
             auto const delinked = node_t::delink_node(toDelink);
             T1_.increase_rank(delinked.first, delinked.second);
             T1_.increase_domain();
+            T1_.lower_check_n_minus_2(2);
+            T1_.lower_check_n_minus_1();
             if (delinked.third)
             {
-                T1_.add_child_checked(delinked.third);
-            }
-            
-            // In case toDelink had more than 3 sons of rank (n-1).
-            while (toDelink->rank_ == T1_.root_->rank_)
-            {
-                auto const delinked = node_t::delink_node(toDelink);
-                T1_.add_delinked_nodes_checked(delinked);
+                this->delink_under_t1(delinked.third);
             }
 
-            T1_.add_child_checked(toDelink);
+            // In case toDelink had more than 3 sons of rank (n-1).
+            this->delink_under_t1(toDelink);
 
             // These might have been created while doing
             // delinking under t2.
@@ -3388,31 +4387,31 @@ namespace idril
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::find_new_root
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::find_new_root
         () const -> node_t*
     {
         auto newRoot = T1_.root_->child_;
 
         node_t::fold_right(newRoot, [&](auto const n)
         {
-            if (*n < *newRoot)
+            if (compare_(**n, **newRoot))
             {
                 newRoot = n;
             }
         });
 
-        node_t::fold_next(T1_.root_->setW_, [&](auto const n)
+        node_t::fold_next(T1_.root_->first_in_W(), [&](auto const n)
         {
-            if (*n < *newRoot)
+            if (compare_(**n, **newRoot))
             {
                 newRoot = n;
             }
         });
 
-        node_t::fold_next(T1_.root_->setV_, [&](auto const n)
+        node_t::fold_next(T1_.root_->first_in_V(), [&](auto const n)
         {
-            if (*n < *newRoot)
+            if (compare_(**n, **newRoot))
             {
                 newRoot = n;
             }
@@ -3421,8 +4420,149 @@ namespace idril
         return newRoot;
     } 
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::add_under_t1
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::is_small
+        () const -> bool
+    {
+        return not T1_.root_;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::promote
+        () -> void
+    {
+        // Array is emptied first so that the nodes go to the trees.
+        auto const count = std::exchange(size_, 0);
+        std::for_each_n(std::begin(small_), count, [this](auto const node)
+        {
+            this->insert_tree_impl(node->reset(links_));
+        });
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::demote
+        () -> void
+    {
+        // Nodes must be collected before they are reset since
+        // the iterator walks through their links.
+        auto count = index_t {0};
+        auto it    = std::begin(*this);
+        auto end   = std::end(*this);
+
+        while (it != end)
+        {
+            small_[count++] = it.current();
+            ++it;
+        }
+
+        T1_                 = t1_wrap {this};
+        T2_                 = t2_wrap {this};
+        deferredSons_       = 0;
+        deferredViolations_ = 0;
+
+        for (auto i = index_t {0}; i < count; ++i)
+        {
+            small_[i]->reset(links_)->rank_ = i;
+        }
+
+        for (auto i = count; i > 0; --i)
+        {
+            this->sift_down(i - 1);
+        }
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::defer
+        (std::uint8_t& counter) -> void
+    {
+        if (++counter == MAX_DEFERRED)
+        {
+            this->repair();
+        }
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::repair
+        () -> void
+    {
+        // Sons are reduced first so that violations reduced
+        // afterwards can be added under t1 with checks.
+        if (deferredSons_ > 0)
+        {
+            deferredSons_ = 0;
+            T1_.reduce_all_sons();
+            this->add_extra_nodes();
+        }
+
+        // Violations are deferred only if there is no t2.
+        if (deferredViolations_ > 0)
+        {
+            deferredViolations_ = 0;
+            T1_.reduce_all_violations();
+        }
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::sift_up
+        (index_t i) -> void
+    {
+        auto const node = small_[i];
+        while (i > 0)
+        {
+            auto const parent = static_cast<index_t>((i - 1) / SMALL_ARITY);
+            if (not compare_(**node, **small_[parent]))
+            {
+                break;
+            }
+
+            small_[i]        = small_[parent];
+            small_[i]->rank_ = i;
+            i                = parent;
+        }
+
+        small_[i]   = node;
+        node->rank_ = i;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::sift_down
+        (index_t i) -> void
+    {
+        auto const node = small_[i];
+        for (;;)
+        {
+            auto const first = SMALL_ARITY * i + 1;
+            if (first >= size_)
+            {
+                break;
+            }
+
+            auto const last = std::min(first + SMALL_ARITY, size_);
+            auto best       = first;
+            for (auto son = first + 1; son < last; ++son)
+            {
+                if (compare_(**small_[son], **small_[best]))
+                {
+                    best = son;
+                }
+            }
+
+            if (not compare_(**small_[best], **node))
+            {
+                break;
+            }
+
+            small_[i]        = small_[best];
+            small_[i]->rank_ = i;
+            i                = static_cast<index_t>(best);
+        }
+
+        small_[i]   = node;
+        node->rank_ = i;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::add_under_t1
         (node_t*& node) -> void
     {
         if (!node)
@@ -3445,8 +4585,28 @@ namespace idril
         node = nullptr;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::add_under_t2
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::delink_under_t1
+        (node_t* const node) -> void
+    {
+        // Rank of t1 can change while nodes are being added
+        // so the node is delinked until it fits under t1.
+        while (node->rank_ >= T1_.root_->rank_)
+        {
+            auto const delinked = node_t::delink_node(node);
+            this->delink_under_t1(delinked.first);
+            this->delink_under_t1(delinked.second);
+            if (delinked.third)
+            {
+                this->delink_under_t1(delinked.third);
+            }
+        }
+
+        T1_.add_child_checked(node);
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::add_under_t2
         (node_t*& node) -> void
     {
         if (!node)
@@ -3464,159 +4624,222 @@ namespace idril
         node = nullptr;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::make_son_of_root
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::make_son_of_root
         (node_t* const newRoot) -> void
     {
         auto const swapped = T1_.sons_[newRoot->rank_]->right_;
         node_t::swap_tree_nodes(newRoot, swapped);
-        if (swapped->is_violating())
+        if (swapped->is_violating(compare_))
         {
             T1_.add_violation(swapped);
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::merge_sets
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::merge_sets
         (node_t* const newRoot) -> void
     {
-        node_t::fold_next(T1_.root_->setV_, [=](auto const n)
+        node_t::fold_next(T1_.root_->first_in_V(), [this](auto const n)
         {
             this->T1_.add_violation(n);
         });
 
-        node_t::fold_next(newRoot->setW_, [=](auto const n)
+        node_t::fold_next(newRoot->first_in_W(), [this](auto const n)
         {
             this->T1_.add_violation(n);
         });
 
-        node_t::fold_next(newRoot->setV_, [=](auto const n)
+        node_t::fold_next(newRoot->first_in_V(), [this](auto const n)
         {
             this->T1_.add_violation(n);
         });
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::shallow_copy_nodes
-        (brodal_queue const& other) -> node_map
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::swallow
+        (brodal_queue& other) -> brodal_queue&
     {
-        auto map = node_map {};
-        auto it  = std::begin(other);
-        auto end = std::end(other);
-
-        while (it != end)
+        // Nodes must be collected before they are reset since the iterator
+        // walks through their links. Nodes of a small queue already are in an array.
+        auto collected = node_stack_t();
+        if (not other.is_small())
         {
-            auto const node     = it.current();
-            auto const nodeCopy = this->shallow_copy_node(node);
-            map.emplace(node, nodeCopy);
-            ++it;
+            collected.reserve(other.size());
+            auto it  = std::begin(other);
+            auto end = std::end(other);
+
+            while (it != end)
+            {
+                collected.push_back(it.current());
+                ++it;
+            }
         }
-        map.emplace(nullptr, nullptr);
 
-        return map;
-    }
+        auto const first = other.is_small() ? other.small_.data() : collected.data();
+        auto const last  = first + other.size();
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::swallow
-        (brodal_queue& other) -> brodal_queue&
-    {
-        auto it  = std::begin(other);
-        auto end = std::end(other);
+        // Other queue no longer owns its nodes and entries.
+        nodes_.splice(other.nodes_);
+        entries_.splice(other.entries_);
+        links_.splice(other.links_);
+        other.T1_   = t1_wrap {&other};
+        other.T2_   = t2_wrap {&other};
+        other.size_ = 0;
 
-        while (it != end)
+        std::for_each(first, last, [this](auto const node)
         {
-            this->insert_impl(it.current()->reset());
-            ++it;
-        }
+            this->insert_impl(node->reset(links_));
+        });
 
-        other = brodal_queue();
         return *this;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::deep_copy_tree
-        (node_map const& map) -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::deep_copy_tree
+        (node_t const* const root, node_pairs& linked) -> node_t*
     {
-        for (auto [original, copy] : map)
+        if (!root)
         {
-            if (copy) [[likely]]
+            return nullptr;
+        }
+
+        // Tree links are rebuilt while walking the tree so only nodes
+        // that are pointed to from elsewhere need to be looked up later.
+        // Those are sons of the root and nodes in violation sets.
+        auto const rootCopy = this->shallow_copy_node(root);
+        rootCopy->child_ = nullptr;
+        linked.emplace_back(root, rootCopy);
+
+        auto pending = node_pairs {{root, rootCopy}};
+        while (!pending.empty())
+        {
+            auto const [parent, parentCopy] = pending.back();
+            pending.pop_back();
+
+            auto leftCopy = static_cast<node_t*>(nullptr);
+            for (auto son = parent->child_; son; son = son->right_)
             {
-                copy->parent_ = map.at(original->parent_);
-                copy->left_   = map.at(original->left_);
-                copy->right_  = map.at(original->right_);
-                copy->child_  = map.at(original->child_);
+                auto const sonCopy = this->shallow_copy_node(son);
+                sonCopy->parent_ = parentCopy;
+                sonCopy->left_   = leftCopy;
+                sonCopy->right_  = nullptr;
+                sonCopy->child_  = nullptr;
+
+                if (leftCopy)
+                {
+                    leftCopy->right_ = sonCopy;
+                }
+                else
+                {
+                    parentCopy->child_ = sonCopy;
+                }
+                leftCopy = sonCopy;
+
+                if (parent == root || son->setLinks_)
+                {
+                    linked.emplace_back(son, sonCopy);
+                }
+
+                if (son->child_)
+                {
+                    pending.emplace_back(son, sonCopy);
+                }
             }
         }
+
+        return rootCopy;
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::deep_copy_violations
-        (node_map const& map) -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::deep_copy_violations
+        (node_pairs& linked) -> void
     {
-        for (auto [original, copy] : map)
+        std::sort(std::begin(linked), std::end(linked), [](auto const& l, auto const& r)
         {
-            if (copy) [[likely]]
+            return std::less<node_t const*>()(l.first, r.first);
+        });
+
+        for (auto const [original, copy] : linked)
+        {
+            if (original->setLinks_)
             {
-                copy->nextInSet_ = map.at(original->nextInSet_);
-                copy->prevInSet_ = map.at(original->prevInSet_);
-                copy->setW_      = map.at(original->setW_);
-                copy->setV_      = map.at(original->setV_);
+                auto& links = copy->set_links(links_);
+                links.nextInSet_ = copy_of(linked, original->next_in_set());
+                links.prevInSet_ = copy_of(linked, original->prev_in_set());
+                links.setW_      = copy_of(linked, original->first_in_W());
+                links.setV_      = copy_of(linked, original->first_in_V());
             }
         }
     }
 
-    template<class T, class Compare, class Allocator>
-    auto brodal_queue<T, Compare, Allocator>::deep_copy_wraps
-        (brodal_queue const& other, node_map const& map) -> void
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::deep_copy_wraps
+        (node_pairs const& linked) -> void
     {
-        T1_.root_ = map.at(other.T1_.root_);
-        T2_.root_ = map.at(other.T2_.root_);
-
         for (auto& son : T1_.sons_)
         {
-            son = map.at(son);
+            son = copy_of(linked, son);
         }
 
         for (auto& son : T2_.sons_)
         {
-            son = map.at(son);
+            son = copy_of(linked, son);
         }
 
         for (auto& violation : T1_.auxW_)
         {
-            violation = map.at(violation);
+            violation = copy_of(linked, violation);
         }
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
+    auto brodal_queue<T, Compare, Allocator, Policy>::copy_of
+        (node_pairs const& linked, node_t const* const node) -> node_t*
+    {
+        if (!node)
+        {
+            return nullptr;
+        }
+
+        auto const it = std::lower_bound(std::begin(linked), std::end(linked), node
+                                        , [](auto const& pair, auto const n)
+        {
+            return std::less<node_t const*>()(pair.first, n);
+        });
+
+        return it != std::end(linked) && it->first == node ? it->second : nullptr;
+    }
+
+    template<class T, class Compare, class Allocator, class Policy>
     auto swap
-        ( brodal_queue<T, Compare, Allocator>& first
-        , brodal_queue<T, Compare, Allocator>& second) noexcept -> void
+        ( brodal_queue<T, Compare, Allocator, Policy>& first
+        , brodal_queue<T, Compare, Allocator, Policy>& second) noexcept -> void
     {
         first.swap(second);
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     auto meld
-        ( brodal_queue<T, Compare, Allocator>& first
-        , brodal_queue<T, Compare, Allocator>& second ) -> brodal_queue<T, Compare, Allocator>
+        ( brodal_queue<T, Compare, Allocator, Policy>& first
+        , brodal_queue<T, Compare, Allocator, Policy>& second ) -> brodal_queue<T, Compare, Allocator, Policy>
     {
         return first.meld(std::move(second));
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     auto operator==
-        ( brodal_queue<T, Compare, Allocator> const& lhs
-        , brodal_queue<T, Compare, Allocator> const& rhs) -> bool
+        ( brodal_queue<T, Compare, Allocator, Policy> const& lhs
+        , brodal_queue<T, Compare, Allocator, Policy> const& rhs) -> bool
     {
         return lhs.size() == rhs.size()
             && std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs));
     }
 
-    template<class T, class Compare, class Allocator>
+    template<class T, class Compare, class Allocator, class Policy>
     auto operator!=
-        ( brodal_queue<T, Compare, Allocator> const& lhs
-        , brodal_queue<T, Compare, Allocator> const& rhs) -> bool
+        ( brodal_queue<T, Compare, Allocator, Policy> const& lhs
+        , brodal_queue<T, Compare, Allocator, Policy> const& rhs) -> bool
     {
         return ! (lhs == rhs);
     }
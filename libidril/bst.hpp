@@ -1,50 +1,105 @@
 #ifndef LIBIDRIL_BST_HPP
 #define LIBIDRIL_BST_HPP
 
+#include "idril_common.hpp"
+#include <compare>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <utility>
 
 namespace idril
 {
-namespace details
+/**
+ *  \brief Balancing options for Bst.
+ */
+namespace balance_mode
 {
-    template<class T>
-    struct less
-    {
-        [[nodiscard]]
-        constexpr auto operator()(T const& l, T const& r) const -> bool
-        {
-            return l < r;
-        }
-    };
+/**
+ *  \brief No balancing.
+ *
+ *  Nodes stay where the search for their key ends, so sorted input
+ *  degenerates the tree into a list.
+ */
+struct None
+{
+};
 
-    template<bool B, class T, class F>
-    struct type_if;
+/**
+ *  \brief Red-black tree.
+ *
+ *  At most two rotations per insertion and three per erasure, height is
+ *  at most 2 log2(n + 1).
+ */
+struct RedBlack
+{
+};
 
-    template<class T, class F>
-    struct type_if<true, T, F>
-    {
-        using type = T;
-    };
+/**
+ *  \brief AVL tree.
+ *
+ *  Heights of the subtrees of every node differ by at most one, height is
+ *  at most 1.44 log2(n + 2). Lookups visit fewer nodes than in a red-black
+ *  tree, updates may rotate all the way up to the root.
+ */
+struct Avl
+{
+};
+} // namespace balance_mode
 
-    template<class T, class F>
-    struct type_if<false, T, F>
-    {
-        using type = F;
-    };
+namespace details
+{
+/**
+ *  \brief Comparator returning std::weak_ordering or std::strong_ordering.
+ */
+template<class Compare, class Key>
+concept ordering_compare = requires (Compare const& cmp, Key const& key)
+{
+    { cmp(key, key) } -> std::convertible_to<std::weak_ordering>;
+};
 
-    template<bool B, class T, class F>
-    using type_if_t = typename type_if<B, T, F>::type;
-}
+/**
+ *  \brief Default operator< comparator of keys that also provide <=>.
+ */
+template<class Compare, class Key>
+concept spaceship_less
+    =  (std::same_as<Compare, less<Key>> || std::same_as<Compare, std::less<Key>>)
+    && std::three_way_comparable<Key, std::weak_ordering>;
+
+/**
+ *  \brief Comparator that accepts other types than the key e.g.,
+ *  std::less<> comparing std::string with std::string_view.
+ */
+template<class Compare>
+concept transparent_compare = requires
+{
+    typename Compare::is_transparent;
+};
+} // namespace details
 
 /**
  *  \version 1.0.0
+ *
+ *  \tparam Compare  Either a strict weak ordering returning bool or
+ *                   a three-way comparison returning std::weak_ordering or
+ *                   std::strong_ordering. Searches compare once per level.
+ *                   If Compare::is_transparent exists, lookups accept any
+ *                   type comparable with the key without converting it.
+ *  \tparam Balance  See the balance_mode namespace above. Defaults to
+ *                   balance_mode::None, so Bst<Key, T> stays the
+ *                   unbalanced tree it has always been. Use
+ *                   balance_mode::RedBlack or balance_mode::Avl for
+ *                   O(log n) operations. It is the last parameter so
+ *                   that Bst<Key, T, Compare, Allocator> keeps its
+ *                   meaning.
  */
 template< class Key
         , class T
         , class Compare   = details::less<Key>
-        , class Allocator = std::allocator<std::pair<Key const, T>> >
+        , class Allocator = std::allocator<std::pair<Key const, T>>
+        , class Balance   = balance_mode::None >
 class Bst
 {
 private:
@@ -60,6 +115,8 @@ private:
         BstNode* parent_ {nullptr};
         BstNode* left_ {nullptr};
         BstNode* right_ {nullptr};
+        // Color for RedBlack, height(right_) - height(left_) for Avl.
+        std::int8_t balance_ {0};
     };
 
     static auto node_key (BstNode*) -> Key const&;
@@ -77,6 +134,25 @@ private:
         BstNode** son_;
     };
 
+    struct ExtractResult
+    {
+        // Node whose subtree lost a node and the son that replaced it.
+        BstNode* parent_;
+        BstNode* son_;
+        bool isLeft_;
+        // Balance of the node that was unlinked from its position.
+        std::int8_t balance_;
+    };
+
+    // Searches with a three-way comparison stop at the equal key, other
+    // ones descend with < only and test for equality at the end.
+    static constexpr bool THREE_WAY
+        =  details::ordering_compare<Compare, Key>
+        || details::spaceship_less<Compare, Key>;
+
+    static constexpr std::int8_t RB_BLACK = 0;
+    static constexpr std::int8_t RB_RED   = 1;
+
 public:
     template<bool IsConst>
     class BstIterator
@@ -94,7 +170,7 @@ public:
         auto operator!= (BstIterator const&) const -> bool;
 
     private:
-        friend class Bst<Key, T, Compare, Allocator>;
+        friend class Bst<Key, T, Compare, Allocator, Balance>;
 
     private:
         BstNode* current_ {nullptr};
@@ -129,17 +205,84 @@ public:
     auto find (key_type const&) -> iterator;
     auto find (key_type const&) const -> const_iterator;
 
+    template<class K> requires details::transparent_compare<Compare>
+    auto find (K const&) -> iterator;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto find (K const&) const -> const_iterator;
+
     auto lookup (key_type const&) -> mapped_type*;
     auto lookup (key_type const&) const -> mapped_type const*;
 
+    template<class K> requires details::transparent_compare<Compare>
+    auto lookup (K const&) -> mapped_type*;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto lookup (K const&) const -> mapped_type const*;
+
+    auto contains (key_type const&) const -> bool;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto contains (K const&) const -> bool;
+
+    auto lower_bound (key_type const&) -> iterator;
+    auto lower_bound (key_type const&) const -> const_iterator;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto lower_bound (K const&) -> iterator;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto lower_bound (K const&) const -> const_iterator;
+
+    auto upper_bound (key_type const&) -> iterator;
+    auto upper_bound (key_type const&) const -> const_iterator;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto upper_bound (K const&) -> iterator;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto upper_bound (K const&) const -> const_iterator;
+
+    auto equal_range (key_type const&) -> std::pair<iterator, iterator>;
+    auto equal_range (key_type const&) const -> std::pair<const_iterator, const_iterator>;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto equal_range (K const&) -> std::pair<iterator, iterator>;
+
+    template<class K> requires details::transparent_compare<Compare>
+    auto equal_range (K const&) const -> std::pair<const_iterator, const_iterator>;
+
+    /**
+     *  \brief Calls \p f with every element whose key is in [lo, hi)
+     *  in key order.
+     *
+     *  Searches the tree once for \p lo and then walks in order, which is
+     *  cheaper than a separate search for every element of the range.
+     */
+    template<class F>
+    auto for_each_in_range (key_type const& lo, key_type const& hi, F&& f) -> void;
+
+    template<class F>
+    auto for_each_in_range (key_type const& lo, key_type const& hi, F&& f) const -> void;
+
+    template<class K, class F> requires details::transparent_compare<Compare>
+    auto for_each_in_range (K const& lo, K const& hi, F&& f) -> void;
+
+    template<class K, class F> requires details::transparent_compare<Compare>
+    auto for_each_in_range (K const& lo, K const& hi, F&& f) const -> void;
+
     auto erase (iterator) -> iterator;
     auto erase (const_iterator) -> iterator;
     auto erase (key_type const&) -> std::size_t;
 
+    template<class K> requires details::transparent_compare<Compare>
+    auto erase (K const&) -> std::size_t;
+
 public:
     Bst ();
     Bst (Bst const&);
     Bst (Bst&&);
+    ~Bst ();
     auto operator= (Bst) -> Bst&;
     auto swap (Bst&) -> void;
     auto size () const -> std::size_t;
@@ -157,15 +300,40 @@ private:
     [[nodiscard]]
     auto new_node (Args&&...) -> BstNode*;
     auto delete_node (BstNode*) -> void;
-    auto find_node (Key const&) const -> BstNode*;
+    template<class K>
+    auto find_node (K const&) const -> BstNode*;
     auto find_spot (Key const&) const -> FindSpotResult;
-    auto compare (Key const&, BstNode*) const -> Ordering;
+    template<class K>
+    auto compare (K const&, BstNode*) const -> Ordering;
+    template<class L, class R>
+    auto is_less (L const&, R const&) const -> bool;
+    template<class K>
+    auto lower_bound_node (K const&) const -> BstNode*;
+    template<class K>
+    auto upper_bound_node (K const&) const -> BstNode*;
+    template<class K>
+    auto equal_range_nodes (K const&) const -> std::pair<BstNode*, BstNode*>;
+    template<class K, class F>
+    auto for_each_node (K const&, K const&, F&&) const -> void;
     template<class... Args>
     auto try_insert (Key const&, Args&&...) -> std::pair<iterator, bool>;
     template<class K, class M>
     auto insert_or_assign_impl (K&&, M&&) -> std::pair<iterator, bool>;
     auto erase_node (BstNode*) -> BstNode*;
-    auto extract_node (BstNode*) -> void;
+    auto extract_node (BstNode*) -> ExtractResult;
+    auto delete_tree () -> void;
+    auto replace_son (BstNode*, BstNode*) -> void;
+    auto rotate_left (BstNode*) -> void;
+    auto rotate_right (BstNode*) -> void;
+
+    auto rebalance_insert (BstNode*, balance_mode::None) -> void;
+    auto rebalance_insert (BstNode*, balance_mode::RedBlack) -> void;
+    auto rebalance_insert (BstNode*, balance_mode::Avl) -> void;
+    auto rebalance_erase (ExtractResult, balance_mode::None) -> void;
+    auto rebalance_erase (ExtractResult, balance_mode::RedBlack) -> void;
+    auto rebalance_erase (ExtractResult, balance_mode::Avl) -> void;
+    auto avl_fix_left_heavy (BstNode*) -> BstNode*;
+    auto avl_fix_right_heavy (BstNode*) -> BstNode*;
 
     static auto next_in_order (BstNode*) -> BstNode*;
     static auto leftmost (BstNode*) -> BstNode*;
@@ -174,6 +342,7 @@ private:
     static auto is_root (BstNode*) -> bool;
     static auto has_right_son (BstNode*) -> bool;
     static auto has_left_son (BstNode*) -> bool;
+    static auto is_red (BstNode*) -> bool;
 
 private:
     using ttt          = std::allocator_traits<Allocator>;
@@ -191,39 +360,39 @@ private:
 
 // bst public api:
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::insert
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::insert
     (value_type const& v) -> std::pair<iterator, bool>
 {
     return this->try_insert(v.first, v);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::insert
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::insert
     (value_type&& v) -> std::pair<iterator, bool>
 {
     return this->try_insert(v.first, std::move(v));
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class M>
-auto Bst<Key, T, Compare, Allocator>::insert_or_assign
+auto Bst<Key, T, Compare, Allocator, Balance>::insert_or_assign
     (key_type const& k, M&& m) -> std::pair<iterator, bool>
 {
     return this->insert_or_assign_impl(k, std::forward<M>(m));
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class M>
-auto Bst<Key, T, Compare, Allocator>::insert_or_assign
+auto Bst<Key, T, Compare, Allocator, Balance>::insert_or_assign
     (key_type&& k, M&& m) -> std::pair<iterator, bool>
 {
     return this->insert_or_assign_impl(std::move(k), std::forward<M>(m));
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-auto Bst<Key, T, Compare, Allocator>::try_emplace
+auto Bst<Key, T, Compare, Allocator, Balance>::try_emplace
     (Key const& k, Args&&... as) -> std::pair<iterator, bool>
 {
     return this->try_insert(
@@ -234,9 +403,9 @@ auto Bst<Key, T, Compare, Allocator>::try_emplace
     );
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-auto Bst<Key, T, Compare, Allocator>::try_emplace
+auto Bst<Key, T, Compare, Allocator, Balance>::try_emplace
     (Key&& k, Args&&... as) -> std::pair<iterator, bool>
 {
     return this->try_insert(
@@ -247,9 +416,9 @@ auto Bst<Key, T, Compare, Allocator>::try_emplace
     );
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-auto Bst<Key, T, Compare, Allocator>::emplace
+auto Bst<Key, T, Compare, Allocator, Balance>::emplace
     (Args&&... as) -> std::pair<iterator, bool>
 {
     if (this->empty())
@@ -270,55 +439,243 @@ auto Bst<Key, T, Compare, Allocator>::emplace
     node->parent_ = parent;
     *sonp = node;
     ++size_;
+    this->rebalance_insert(node, Balance());
     return {node, true};
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::find
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::find
     (key_type const& k) -> iterator
 {
     return iterator(this->find_node(k));
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::find
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::find
     (key_type const& k) const -> const_iterator
 {
     return const_iterator(this->find_node(k));
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::lookup
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::lookup
     (key_type const& k) -> mapped_type*
 {
     auto const node = this->find_node(k);
     return node ? &node_data(node) : nullptr;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::lookup
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::lookup
     (key_type const& k) const -> mapped_type const*
 {
     auto const node = this->find_node(k);
     return node ? &node_data(node) : nullptr;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::erase
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::find
+    (K const& k) -> iterator
+{
+    return iterator(this->find_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::find
+    (K const& k) const -> const_iterator
+{
+    return const_iterator(this->find_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::lookup
+    (K const& k) -> mapped_type*
+{
+    auto const node = this->find_node(k);
+    return node ? &node_data(node) : nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::lookup
+    (K const& k) const -> mapped_type const*
+{
+    auto const node = this->find_node(k);
+    return node ? &node_data(node) : nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::contains
+    (key_type const& k) const -> bool
+{
+    return this->find_node(k) != nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::contains
+    (K const& k) const -> bool
+{
+    return this->find_node(k) != nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::lower_bound
+    (key_type const& k) -> iterator
+{
+    return iterator(this->lower_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::lower_bound
+    (key_type const& k) const -> const_iterator
+{
+    return const_iterator(this->lower_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::lower_bound
+    (K const& k) -> iterator
+{
+    return iterator(this->lower_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::lower_bound
+    (K const& k) const -> const_iterator
+{
+    return const_iterator(this->lower_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::upper_bound
+    (key_type const& k) -> iterator
+{
+    return iterator(this->upper_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::upper_bound
+    (key_type const& k) const -> const_iterator
+{
+    return const_iterator(this->upper_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::upper_bound
+    (K const& k) -> iterator
+{
+    return iterator(this->upper_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::upper_bound
+    (K const& k) const -> const_iterator
+{
+    return const_iterator(this->upper_bound_node(k));
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::equal_range
+    (key_type const& k) -> std::pair<iterator, iterator>
+{
+    auto const [first, last] = this->equal_range_nodes(k);
+    return {iterator(first), iterator(last)};
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::equal_range
+    (key_type const& k) const -> std::pair<const_iterator, const_iterator>
+{
+    auto const [first, last] = this->equal_range_nodes(k);
+    return {const_iterator(first), const_iterator(last)};
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::equal_range
+    (K const& k) -> std::pair<iterator, iterator>
+{
+    auto const [first, last] = this->equal_range_nodes(k);
+    return {iterator(first), iterator(last)};
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::equal_range
+    (K const& k) const -> std::pair<const_iterator, const_iterator>
+{
+    auto const [first, last] = this->equal_range_nodes(k);
+    return {const_iterator(first), const_iterator(last)};
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class F>
+auto Bst<Key, T, Compare, Allocator, Balance>::for_each_in_range
+    (key_type const& lo, key_type const& hi, F&& f) -> void
+{
+    this->for_each_node(lo, hi, [&f](BstNode* const node)
+    {
+        f(node->data_);
+    });
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class F>
+auto Bst<Key, T, Compare, Allocator, Balance>::for_each_in_range
+    (key_type const& lo, key_type const& hi, F&& f) const -> void
+{
+    this->for_each_node(lo, hi, [&f](BstNode* const node)
+    {
+        f(std::as_const(node->data_));
+    });
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K, class F> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::for_each_in_range
+    (K const& lo, K const& hi, F&& f) -> void
+{
+    this->for_each_node(lo, hi, [&f](BstNode* const node)
+    {
+        f(node->data_);
+    });
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K, class F> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::for_each_in_range
+    (K const& lo, K const& hi, F&& f) const -> void
+{
+    this->for_each_node(lo, hi, [&f](BstNode* const node)
+    {
+        f(std::as_const(node->data_));
+    });
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::erase
     (iterator const it) -> iterator
 {
     return this->erase_node(it.current_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::erase
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::erase
     (const_iterator const it) -> iterator
 {
     return this->erase_node(it.current_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::erase
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::erase
     (Key const& k) -> std::size_t
 {
     auto const node = this->find_node(k);
@@ -330,8 +687,22 @@ auto Bst<Key, T, Compare, Allocator>::erase
     return 1;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-Bst<Key, T, Compare, Allocator>::Bst
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K> requires details::transparent_compare<Compare>
+auto Bst<Key, T, Compare, Allocator, Balance>::erase
+    (K const& k) -> std::size_t
+{
+    auto const node = this->find_node(k);
+    if (not node)
+    {
+        return 0;
+    }
+    this->erase_node(node);
+    return 1;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+Bst<Key, T, Compare, Allocator, Balance>::Bst
     () :
     root_  (nullptr),
     size_  (0),
@@ -340,15 +711,59 @@ Bst<Key, T, Compare, Allocator>::Bst
 {
 }
 
-template<class Key, class T, class Compare, class Allocator>
-Bst<Key, T, Compare, Allocator>::Bst
-    (Bst const&)
+template<class Key, class T, class Compare, class Allocator, class Balance>
+Bst<Key, T, Compare, Allocator, Balance>::Bst
+    (Bst const& o) :
+    root_  (nullptr),
+    size_  (o.size_),
+    alloc_ (alloc_traits::select_on_container_copy_construction(o.alloc_)),
+    cmp_   (o.cmp_)
 {
-    // TODO
+    if (not o.root_)
+    {
+        return;
+    }
+
+    try
+    {
+        root_ = this->new_node(o.root_->data_);
+        root_->balance_ = o.root_->balance_;
+        auto src = o.root_;
+        auto dst = root_;
+        while (src)
+        {
+            if (src->left_ && not dst->left_)
+            {
+                dst->left_ = this->new_node(src->left_->data_);
+                dst->left_->parent_ = dst;
+                dst->left_->balance_ = src->left_->balance_;
+                src = src->left_;
+                dst = dst->left_;
+            }
+            else if (src->right_ && not dst->right_)
+            {
+                dst->right_ = this->new_node(src->right_->data_);
+                dst->right_->parent_ = dst;
+                dst->right_->balance_ = src->right_->balance_;
+                src = src->right_;
+                dst = dst->right_;
+            }
+            else
+            {
+                src = src->parent_;
+                dst = dst->parent_;
+            }
+        }
+    }
+    catch (...)
+    {
+        this->delete_tree();
+        throw;
+    }
 }
 
-template<class Key, class T, class Compare, class Allocator>
-Bst<Key, T, Compare, Allocator>::Bst
+template<class Key, class T, class Compare, class Allocator, class Balance>
+Bst<Key, T, Compare, Allocator, Balance>::Bst
     (Bst&& o) :
     root_  (std::exchange(o.root_, nullptr)),
     size_  (std::exchange(o.size_, 0)),
@@ -357,16 +772,23 @@ Bst<Key, T, Compare, Allocator>::Bst
 {
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::operator=
+template<class Key, class T, class Compare, class Allocator, class Balance>
+Bst<Key, T, Compare, Allocator, Balance>::~Bst
+    ()
+{
+    this->delete_tree();
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::operator=
     (Bst o) -> Bst&
 {
     this->swap(o);
     return *this;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::swap
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::swap
     (Bst& o) -> void
 {
     using std::swap;
@@ -376,64 +798,64 @@ auto Bst<Key, T, Compare, Allocator>::swap
     swap(cmp_, o.cmp_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::size
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::size
     () const -> std::size_t
 {
     return size_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::ssize
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::ssize
     () const -> std::ptrdiff_t
 {
     return static_cast<std::ptrdiff_t>(size_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::empty
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::empty
     () const -> bool
 {
     return 0 == this->size();
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::begin
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::begin
     () -> iterator
 {
-    return iterator(root_);
+    return iterator(root_ ? leftmost(root_) : nullptr);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::end
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::end
     () -> iterator
 {
     return iterator();
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::begin
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::begin
     () const -> const_iterator
 {
-    return const_iterator(root_);
+    return const_iterator(root_ ? leftmost(root_) : nullptr);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::end
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::end
     () const -> const_iterator
 {
     return const_iterator();
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::cbegin
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::cbegin
     () const -> const_iterator
 {
-    return const_iterator(root_);
+    return const_iterator(root_ ? leftmost(root_) : nullptr);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::cend
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::cend
     () const -> const_iterator
 {
     return const_iterator();
@@ -442,9 +864,9 @@ auto Bst<Key, T, Compare, Allocator>::cend
 
 // bst private api:
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-auto Bst<Key, T, Compare, Allocator>::new_node
+auto Bst<Key, T, Compare, Allocator, Balance>::new_node
     (Args&&... as) -> BstNode*
 {
     auto p = std::allocator_traits<allocator>::allocate(alloc_, 1);
@@ -456,80 +878,152 @@ auto Bst<Key, T, Compare, Allocator>::new_node
     return p;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::delete_node
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::delete_node
     (BstNode* const p) -> void
 {
     std::allocator_traits<allocator>::destroy(alloc_, p);
     std::allocator_traits<allocator>::deallocate(alloc_, p, 1);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::find_node
-    (Key const& key) const -> BstNode*
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K>
+auto Bst<Key, T, Compare, Allocator, Balance>::find_node
+    (K const& key) const -> BstNode*
 {
-    auto pos = root_;
-    while (pos != nullptr)
+    if constexpr (not THREE_WAY)
+    {
+        // The last node that is not less than the key is the only one
+        // that can be equal to it.
+        auto candidate = static_cast<BstNode*>(nullptr);
+        auto pos = root_;
+        while (pos != nullptr)
+        {
+            if (cmp_(node_key(pos), key))
+            {
+                pos = pos->right_;
+            }
+            else
+            {
+                candidate = pos;
+                pos = pos->left_;
+            }
+        }
+        return candidate && not cmp_(key, node_key(candidate))
+            ? candidate
+            : nullptr;
+    }
+    else
     {
-        auto const ord = this->compare(key, pos);
-        switch (ord)
+        auto pos = root_;
+        while (pos != nullptr)
         {
-        case Ordering::EQ:
-            return pos;
+            auto const ord = this->compare(key, pos);
+            switch (ord)
+            {
+            case Ordering::EQ:
+                return pos;
 
-        case Ordering::LT:
-            pos = pos->left;
-            break;
+            case Ordering::LT:
+                pos = pos->left_;
+                break;
 
-        case Ordering::GT:
-            pos = pos->right;
-            break;
+            case Ordering::GT:
+                pos = pos->right_;
+                break;
+            }
         }
+        return nullptr;
     }
-    return nullptr;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::find_spot
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::find_spot
     (Key const& key) const -> FindSpotResult
 {
     auto parent = root_;
     auto sonp = static_cast<BstNode**>(nullptr);
-    do
+    if constexpr (not THREE_WAY)
     {
-        auto const ord = this->compare(key, parent);
-        switch (ord)
+        // The last node that is not greater than the key is the only one
+        // that can be equal to it.
+        auto candidate = static_cast<BstNode*>(nullptr);
+        do
         {
-        case Ordering::EQ:
-            return {parent, nullptr};
-
-        case Ordering::LT:
-            sonp = &parent->left_;
-            break;
+            if (cmp_(key, node_key(parent)))
+            {
+                sonp = &parent->left_;
+            }
+            else
+            {
+                candidate = parent;
+                sonp = &parent->right_;
+            }
 
-        case Ordering::GT:
-            sonp = &parent->right_;
-            break;
+            if (*sonp != nullptr)
+            {
+                parent = *sonp;
+            }
         }
+        while (*sonp != nullptr);
 
-        if (*sonp != nullptr)
+        if (candidate && not cmp_(node_key(candidate), key))
         {
-            parent = *sonp;
+            return {candidate, nullptr};
         }
+        return {parent, sonp};
+    }
+    else
+    {
+        do
+        {
+            auto const ord = this->compare(key, parent);
+            switch (ord)
+            {
+            case Ordering::EQ:
+                return {parent, nullptr};
+
+            case Ordering::LT:
+                sonp = &parent->left_;
+                break;
+
+            case Ordering::GT:
+                sonp = &parent->right_;
+                break;
+            }
+
+            if (*sonp != nullptr)
+            {
+                parent = *sonp;
+            }
+        }
+        while (*sonp != nullptr);
+        return {parent, sonp};
     }
-    while (*sonp != nullptr);
-    return {parent, sonp};
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::compare
-    (Key const& key, BstNode* const node) const -> Ordering
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K>
+auto Bst<Key, T, Compare, Allocator, Balance>::compare
+    (K const& key, BstNode* const node) const -> Ordering
 {
-    if (cmp_(key, node_key(node)))
+    auto const ord = [this, &key, node]
+    {
+        if constexpr (details::ordering_compare<Compare, Key>)
+        {
+            return std::weak_ordering(cmp_(key, node_key(node)));
+        }
+        else
+        {
+            return std::weak_ordering(key <=> node_key(node));
+        }
+    }();
+
+    if (ord < 0)
     {
         return Ordering::LT;
     }
-    else if (cmp_(node_key(node), key))
+    else if (ord > 0)
     {
         return Ordering::GT;
     }
@@ -539,9 +1033,95 @@ auto Bst<Key, T, Compare, Allocator>::compare
     }
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class L, class R>
+auto Bst<Key, T, Compare, Allocator, Balance>::is_less
+    (L const& l, R const& r) const -> bool
+{
+    if constexpr (details::ordering_compare<Compare, Key>)
+    {
+        return cmp_(l, r) < 0;
+    }
+    else
+    {
+        return cmp_(l, r);
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K>
+auto Bst<Key, T, Compare, Allocator, Balance>::lower_bound_node
+    (K const& key) const -> BstNode*
+{
+    auto result = static_cast<BstNode*>(nullptr);
+    auto pos = root_;
+    while (pos != nullptr)
+    {
+        if (this->is_less(node_key(pos), key))
+        {
+            pos = pos->right_;
+        }
+        else
+        {
+            result = pos;
+            pos = pos->left_;
+        }
+    }
+    return result;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K>
+auto Bst<Key, T, Compare, Allocator, Balance>::upper_bound_node
+    (K const& key) const -> BstNode*
+{
+    auto result = static_cast<BstNode*>(nullptr);
+    auto pos = root_;
+    while (pos != nullptr)
+    {
+        if (this->is_less(key, node_key(pos)))
+        {
+            result = pos;
+            pos = pos->left_;
+        }
+        else
+        {
+            pos = pos->right_;
+        }
+    }
+    return result;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K>
+auto Bst<Key, T, Compare, Allocator, Balance>::equal_range_nodes
+    (K const& key) const -> std::pair<BstNode*, BstNode*>
+{
+    // Keys are unique so the range has at most one node.
+    auto const first = this->lower_bound_node(key);
+    if (first && not this->is_less(key, node_key(first)))
+    {
+        return {first, next_in_order(first)};
+    }
+    return {first, first};
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+template<class K, class F>
+auto Bst<Key, T, Compare, Allocator, Balance>::for_each_node
+    (K const& lo, K const& hi, F&& f) const -> void
+{
+    auto node = this->lower_bound_node(lo);
+    while (node && this->is_less(node_key(node), hi))
+    {
+        f(node);
+        node = next_in_order(node);
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-auto Bst<Key, T, Compare, Allocator>::try_insert
+auto Bst<Key, T, Compare, Allocator, Balance>::try_insert
     (Key const& k, Args&&... as) -> std::pair<iterator, bool>
 {
     if (this->empty())
@@ -561,18 +1141,19 @@ auto Bst<Key, T, Compare, Allocator>::try_insert
     node->parent_ = parent;
     *sonp = node;
     ++size_;
+    this->rebalance_insert(node, Balance());
     return {node, true};
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class K, class M>
-auto Bst<Key, T, Compare, Allocator>::insert_or_assign_impl
+auto Bst<Key, T, Compare, Allocator, Balance>::insert_or_assign_impl
     (K&& k, M&& m) -> std::pair<iterator, bool>
 {
     auto [it, isIn] = this->try_insert(
         k,
         std::piecewise_construct,
-        std::forward_as_tuple(std::forward<M>(k)),
+        std::forward_as_tuple(std::forward<K>(k)),
         std::forward_as_tuple(std::forward<M>(m))
     );
 
@@ -586,97 +1167,400 @@ auto Bst<Key, T, Compare, Allocator>::insert_or_assign_impl
     return {it, false};
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::erase_node
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::erase_node
     (BstNode* const node) -> BstNode*
 {
     auto const n = next_in_order(node);
-    this->extract_node(node);
+    auto const extracted = this->extract_node(node);
+    this->rebalance_erase(extracted, Balance());
     this->delete_node(node);
     --size_;
     return n;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::extract_node
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::extract_node
+    (BstNode* const node) -> ExtractResult
+{
+    if (node_degree(node) < 2)
+    {
+        auto const son = node->left_ ? node->left_ : node->right_;
+        auto const isLeft = is_left_son(node);
+        this->replace_son(node, son);
+        if (son)
+        {
+            son->parent_ = node->parent_;
+        }
+        return {node->parent_, son, isLeft, node->balance_};
+    }
+
+    // The successor takes the place and balance of the node, its own old
+    // position is the one that lost a node.
+    auto const next = leftmost(node->right_);
+    auto result = this->extract_node(next);
+    if (result.parent_ == node)
+    {
+        result.parent_ = next;
+    }
+
+    next->parent_ = node->parent_;
+    next->left_ = node->left_;
+    next->right_ = node->right_;
+    next->balance_ = node->balance_;
+
+    if (node->left_)
+    {
+        node->left_->parent_ = next;
+    }
+
+    if (node->right_)
+    {
+        node->right_->parent_ = next;
+    }
+
+    this->replace_son(node, next);
+    return result;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::delete_tree
+    () -> void
+{
+    auto node = root_;
+    while (node)
+    {
+        if (node->left_)
+        {
+            node = node->left_;
+        }
+        else if (node->right_)
+        {
+            node = node->right_;
+        }
+        else
+        {
+            auto const parent = node->parent_;
+            this->replace_son(node, nullptr);
+            this->delete_node(node);
+            node = parent;
+        }
+    }
+    size_ = 0;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::replace_son
+    (BstNode* const node, BstNode* const son) -> void
+{
+    if (is_left_son(node))
+    {
+        node->parent_->left_ = son;
+    }
+    else if (is_right_son(node))
+    {
+        node->parent_->right_ = son;
+    }
+    else
+    {
+        root_ = son;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rotate_left
+    (BstNode* const node) -> void
+{
+    auto const son = node->right_;
+    node->right_ = son->left_;
+    if (son->left_)
+    {
+        son->left_->parent_ = node;
+    }
+    this->replace_son(node, son);
+    son->parent_ = node->parent_;
+    son->left_ = node;
+    node->parent_ = son;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rotate_right
     (BstNode* const node) -> void
 {
-    auto const d = node_degree(node);
-    switch (d)
+    auto const son = node->left_;
+    node->left_ = son->right_;
+    if (son->right_)
+    {
+        son->right_->parent_ = node;
+    }
+    this->replace_son(node, son);
+    son->parent_ = node->parent_;
+    son->right_ = node;
+    node->parent_ = son;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_insert
+    (BstNode*, balance_mode::None) -> void
+{
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_insert
+    (BstNode* node, balance_mode::RedBlack) -> void
+{
+    node->balance_ = RB_RED;
+    while (node != root_ && is_red(node->parent_))
     {
-    case 0:
+        // Red parent is never the root so the grandparent exists.
+        auto parent = node->parent_;
+        auto const grand = parent->parent_;
+        if (parent == grand->left_)
         {
-            if (is_left_son(node))
+            auto const uncle = grand->right_;
+            if (is_red(uncle))
             {
-                node->parent_->left_ = nullptr;
+                parent->balance_ = RB_BLACK;
+                uncle->balance_ = RB_BLACK;
+                grand->balance_ = RB_RED;
+                node = grand;
+                continue;
             }
-            else if (is_right_son(node))
-            {
-                node->parent_->right_ = nullptr;
-            }
-            else
+
+            if (node == parent->right_)
             {
-                root_ = nullptr;
+                this->rotate_left(parent);
+                parent = node;
             }
+            parent->balance_ = RB_BLACK;
+            grand->balance_ = RB_RED;
+            this->rotate_right(grand);
+            break;
         }
-        break;
-
-    case 1:
+        else
         {
-            auto const son = node->left_ ? node->left_ : node->right_;
-            if (is_left_son(node))
+            auto const uncle = grand->left_;
+            if (is_red(uncle))
             {
-                node->parent_->left_ = son;
+                parent->balance_ = RB_BLACK;
+                uncle->balance_ = RB_BLACK;
+                grand->balance_ = RB_RED;
+                node = grand;
+                continue;
             }
-            else if (is_right_son(node))
-            {
-                node->parent_->right_ = son;
-            }
-            else
+
+            if (node == parent->left_)
             {
-                root_ = son;
+                this->rotate_right(parent);
+                parent = node;
             }
-            son->parent_ = node->parent_;
+            parent->balance_ = RB_BLACK;
+            grand->balance_ = RB_RED;
+            this->rotate_left(grand);
+            break;
+        }
+    }
+    root_->balance_ = RB_BLACK;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_insert
+    (BstNode* node, balance_mode::Avl) -> void
+{
+    // Height of the subtree of node grew by one.
+    for (auto parent = node->parent_; parent; node = parent, parent = node->parent_)
+    {
+        parent->balance_ += node == parent->left_ ? -1 : 1;
+        if (parent->balance_ == 0)
+        {
+            return;
+        }
+
+        if (parent->balance_ == -2)
+        {
+            this->avl_fix_left_heavy(parent);
+            return;
         }
-        break;
 
-    case 2:
+        if (parent->balance_ == 2)
         {
-            auto const next = leftmost(node->right_);
-            this->extract_node(next);
-            next->parent_ = node->parent_;
-            next->left_ = node->left_;
-            next->right_ = node->right_;
+            this->avl_fix_right_heavy(parent);
+            return;
+        }
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_erase
+    (ExtractResult, balance_mode::None) -> void
+{
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_erase
+    (ExtractResult const e, balance_mode::RedBlack) -> void
+{
+    if (e.balance_ == RB_RED)
+    {
+        return;
+    }
 
-            if (node->left_)
+    // The son carries an extra black, a missing son is black.
+    auto node = e.son_;
+    auto parent = e.parent_;
+    auto isLeft = e.isLeft_;
+    while (node != root_ && not is_red(node))
+    {
+        if (isLeft)
+        {
+            auto sibling = parent->right_;
+            if (is_red(sibling))
             {
-                node->left_->parent_ = next;
+                sibling->balance_ = RB_BLACK;
+                parent->balance_ = RB_RED;
+                this->rotate_left(parent);
+                sibling = parent->right_;
             }
 
-            if (node->right_)
+            if (not is_red(sibling->left_) && not is_red(sibling->right_))
             {
-                node->right_->parent_ = next;
+                sibling->balance_ = RB_RED;
+                node = parent;
+                parent = node->parent_;
+                isLeft = is_left_son(node);
+                continue;
             }
 
-            if (is_left_son(node))
+            if (not is_red(sibling->right_))
             {
-                node->parent_->left_ = next;
+                sibling->left_->balance_ = RB_BLACK;
+                sibling->balance_ = RB_RED;
+                this->rotate_right(sibling);
+                sibling = parent->right_;
             }
-            else if (is_right_son(node))
+            sibling->balance_ = parent->balance_;
+            parent->balance_ = RB_BLACK;
+            sibling->right_->balance_ = RB_BLACK;
+            this->rotate_left(parent);
+            return;
+        }
+        else
+        {
+            auto sibling = parent->left_;
+            if (is_red(sibling))
             {
-                node->parent_->right_ = next;
+                sibling->balance_ = RB_BLACK;
+                parent->balance_ = RB_RED;
+                this->rotate_right(parent);
+                sibling = parent->left_;
             }
-            else
+
+            if (not is_red(sibling->left_) && not is_red(sibling->right_))
+            {
+                sibling->balance_ = RB_RED;
+                node = parent;
+                parent = node->parent_;
+                isLeft = is_left_son(node);
+                continue;
+            }
+
+            if (not is_red(sibling->left_))
             {
-                root_ = next;
+                sibling->right_->balance_ = RB_BLACK;
+                sibling->balance_ = RB_RED;
+                this->rotate_left(sibling);
+                sibling = parent->left_;
             }
+            sibling->balance_ = parent->balance_;
+            parent->balance_ = RB_BLACK;
+            sibling->left_->balance_ = RB_BLACK;
+            this->rotate_right(parent);
+            return;
+        }
+    }
+
+    if (node)
+    {
+        node->balance_ = RB_BLACK;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::rebalance_erase
+    (ExtractResult const e, balance_mode::Avl) -> void
+{
+    // Height of one subtree of parent shrank by one.
+    auto parent = e.parent_;
+    auto isLeft = e.isLeft_;
+    while (parent)
+    {
+        parent->balance_ += isLeft ? 1 : -1;
+        if (parent->balance_ == -2)
+        {
+            parent = this->avl_fix_left_heavy(parent);
         }
-        break;
+        else if (parent->balance_ == 2)
+        {
+            parent = this->avl_fix_right_heavy(parent);
+        }
+
+        // Height of the subtree is unchanged unless it is balanced now.
+        if (parent->balance_ != 0)
+        {
+            return;
+        }
+
+        isLeft = is_left_son(parent);
+        parent = parent->parent_;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::avl_fix_left_heavy
+    (BstNode* const node) -> BstNode*
+{
+    auto const son = node->left_;
+    if (son->balance_ <= 0)
+    {
+        this->rotate_right(node);
+        node->balance_ = son->balance_ == 0 ? -1 : 0;
+        son->balance_ = son->balance_ == 0 ? 1 : 0;
+        return son;
     }
+
+    auto const grand = son->right_;
+    this->rotate_left(son);
+    this->rotate_right(node);
+    node->balance_ = grand->balance_ == -1 ? 1 : 0;
+    son->balance_ = grand->balance_ == 1 ? -1 : 0;
+    grand->balance_ = 0;
+    return grand;
+}
+
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::avl_fix_right_heavy
+    (BstNode* const node) -> BstNode*
+{
+    auto const son = node->right_;
+    if (son->balance_ >= 0)
+    {
+        this->rotate_left(node);
+        node->balance_ = son->balance_ == 0 ? 1 : 0;
+        son->balance_ = son->balance_ == 0 ? -1 : 0;
+        return son;
+    }
+
+    auto const grand = son->left_;
+    this->rotate_right(son);
+    this->rotate_left(node);
+    node->balance_ = grand->balance_ == 1 ? -1 : 0;
+    son->balance_ = grand->balance_ == -1 ? 1 : 0;
+    grand->balance_ = 0;
+    return grand;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::next_in_order
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::next_in_order
     (BstNode* node) -> BstNode*
 {
     if (has_right_son(node))
@@ -693,8 +1577,8 @@ auto Bst<Key, T, Compare, Allocator>::next_in_order
     }
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::leftmost
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::leftmost
     (BstNode* root) -> BstNode*
 {
     while (has_left_son(root))
@@ -704,67 +1588,74 @@ auto Bst<Key, T, Compare, Allocator>::leftmost
     return root;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::is_left_son
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::is_left_son
     (BstNode* const n) -> bool
 {
     return n->parent_ && n == n->parent_->left_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::is_right_son
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::is_right_son
     (BstNode* const n) -> bool
 {
     return n->parent_ && n == n->parent_->right_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::is_root
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::is_root
     (BstNode* const n) -> bool
 {
-    return n->parent_;
+    return not n->parent_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::has_right_son
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::has_right_son
     (BstNode* const n) -> bool
 {
     return n->right_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::has_left_son
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::has_left_son
     (BstNode* const n) -> bool
 {
     return n->left_;
 }
 
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::is_red
+    (BstNode* const n) -> bool
+{
+    return n && n->balance_ == RB_RED;
+}
+
 // bst::bst_node:
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<class... Args>
-Bst<Key, T, Compare, Allocator>::BstNode::BstNode
+Bst<Key, T, Compare, Allocator, Balance>::BstNode::BstNode
     (Args&&... as) :
     data_ (std::forward<Args>(as)...)
 {
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::node_key
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::node_key
     (BstNode* const node) -> Key const&
 {
     return std::get<0>(node->data_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::node_data
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::node_data
     (BstNode* const node) -> T&
 {
     return std::get<1>(node->data_);
 }
 
-template<class Key, class T, class Compare, class Allocator>
-auto Bst<Key, T, Compare, Allocator>::node_degree
+template<class Key, class T, class Compare, class Allocator, class Balance>
+auto Bst<Key, T, Compare, Allocator, Balance>::node_degree
     (BstNode* const node) -> int
 {
     auto d = 0;
@@ -775,42 +1666,42 @@ auto Bst<Key, T, Compare, Allocator>::node_degree
 
 // bst::bst_iterator:
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<bool IsConst>
-Bst<Key, T, Compare, Allocator>::BstIterator<IsConst>::BstIterator
-    (BstNode* const root) :
-    current_ (leftmost(root))
+Bst<Key, T, Compare, Allocator, Balance>::BstIterator<IsConst>::BstIterator
+    (BstNode* const node) :
+    current_ (node)
 {
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<bool IsConst>
-auto Bst<Key, T, Compare, Allocator>::BstIterator<IsConst>::operator*
+auto Bst<Key, T, Compare, Allocator, Balance>::BstIterator<IsConst>::operator*
     () const -> pair_t&
 {
     return current_->data_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<bool IsConst>
-auto Bst<Key, T, Compare, Allocator>::BstIterator<IsConst>::operator++
+auto Bst<Key, T, Compare, Allocator, Balance>::BstIterator<IsConst>::operator++
     () -> BstIterator&
 {
     current_ = next_in_order(current_);
     return *this;
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<bool IsConst>
-auto Bst<Key, T, Compare, Allocator>::BstIterator<IsConst>::operator==
+auto Bst<Key, T, Compare, Allocator, Balance>::BstIterator<IsConst>::operator==
     (BstIterator const& other) const -> bool
 {
     return current_ == other.current_;
 }
 
-template<class Key, class T, class Compare, class Allocator>
+template<class Key, class T, class Compare, class Allocator, class Balance>
 template<bool IsConst>
-auto Bst<Key, T, Compare, Allocator>::BstIterator<IsConst>::operator!=
+auto Bst<Key, T, Compare, Allocator, Balance>::BstIterator<IsConst>::operator!=
     (BstIterator const& other) const -> bool
 {
     return not (*this == other);
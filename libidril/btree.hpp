@@ -0,0 +1,1216 @@
+#ifndef LIBIDRIL_BTREE_HPP
+#define LIBIDRIL_BTREE_HPP
+
+#include "idril_common.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace idril
+{
+/**
+ *  \brief Ordered map stored in a B+ tree.
+ *
+ *  Elements live in leaves that are linked in key order, inner nodes only
+ *  hold copies of separator keys. Keys of a node are stored contiguously
+ *  and apart from the mapped values so that a search reads a few cache
+ *  lines per level instead of one node per key as in Bst.
+ *
+ *  Interface is the same as the one of Bst except that iterators
+ *  dereference to a pair of references instead of a reference to a pair.
+ *  Insertion and erasure move elements between nodes and invalidate all
+ *  iterators.
+ *
+ *  \tparam Key        The type of the keys, must be copy constructible.
+ *  \tparam T          The type of the mapped values.
+ *  \tparam Compare    A type providing a strict weak ordering of keys.
+ *  \tparam Allocator  Allocator for internal memory management.
+ */
+template< class Key
+        , class T
+        , class Compare   = details::less<Key>
+        , class Allocator = std::allocator<std::pair<Key const, T>> >
+class BTree
+{
+private:
+    // Keys of a node span about four cache lines.
+    static constexpr std::size_t NODE_BYTES = 256;
+    static constexpr std::size_t CAPACITY
+        = std::clamp<std::size_t>(NODE_BYTES / sizeof(Key), 8, 64);
+    static constexpr std::size_t MIN_COUNT = CAPACITY / 2;
+
+    struct Inner;
+
+    struct Node
+    {
+        Node (bool);
+
+        Inner* parent_ {nullptr};
+        // Index in parent_->sons_.
+        std::uint16_t position_ {0};
+        // Number of keys.
+        std::uint16_t count_ {0};
+        bool isLeaf_;
+    };
+
+    struct Leaf : Node
+    {
+        Leaf ();
+        ~Leaf ();
+
+        union { Key keys_[CAPACITY]; };
+        union { T values_[CAPACITY]; };
+        Leaf* next_ {nullptr};
+    };
+
+    struct Inner : Node
+    {
+        Inner ();
+        ~Inner ();
+
+        // keys_[i] separates keys in sons_[i] and sons_[i + 1].
+        union { Key keys_[CAPACITY]; };
+        Node* sons_[CAPACITY + 1];
+    };
+
+public:
+    template<bool IsConst>
+    class BTreeIterator
+    {
+    private:
+        using mapped_t = typename details::type_if_t<IsConst, T const, T>;
+
+    public:
+        using reference = std::pair<Key const&, mapped_t&>;
+
+    public:
+        BTreeIterator () = default;
+        BTreeIterator (Leaf*, std::size_t);
+
+        auto operator* () const -> reference;
+        auto operator++ () -> BTreeIterator&;
+        auto operator== (BTreeIterator const&) const -> bool;
+        auto operator!= (BTreeIterator const&) const -> bool;
+
+    private:
+        friend class BTree<Key, T, Compare, Allocator>;
+
+    private:
+        Leaf* leaf_ {nullptr};
+        std::size_t index_ {0};
+    };
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key const, T>;
+    using iterator = BTreeIterator<false>;
+    using const_iterator = BTreeIterator<true>;
+
+public:
+    auto insert (value_type const&) -> std::pair<iterator, bool>;
+    auto insert (value_type&&) -> std::pair<iterator, bool>;
+
+    template<class M>
+    auto insert_or_assign (key_type const&, M&&) -> std::pair<iterator, bool>;
+
+    template<class M>
+    auto insert_or_assign (key_type&&, M&&) -> std::pair<iterator, bool>;
+
+    template<class... Args>
+    auto try_emplace (key_type const&, Args&&...) -> std::pair<iterator, bool>;
+
+    template<class... Args>
+    auto try_emplace (key_type&&, Args&&...) -> std::pair<iterator, bool>;
+
+    template<class... Args>
+    auto emplace (Args&&...) -> std::pair<iterator, bool>;
+
+    auto find (key_type const&) -> iterator;
+    auto find (key_type const&) const -> const_iterator;
+
+    auto lookup (key_type const&) -> mapped_type*;
+    auto lookup (key_type const&) const -> mapped_type const*;
+
+    auto erase (iterator) -> iterator;
+    auto erase (const_iterator) -> iterator;
+    auto erase (key_type const&) -> std::size_t;
+
+public:
+    BTree ();
+    BTree (BTree const&);
+    BTree (BTree&&);
+    ~BTree ();
+    auto operator= (BTree) -> BTree&;
+    auto swap (BTree&) -> void;
+    auto size () const -> std::size_t;
+    auto ssize () const -> std::ptrdiff_t;
+    auto empty() const -> bool;
+    auto begin () -> iterator;
+    auto end () -> iterator;
+    auto begin () const -> const_iterator;
+    auto end () const -> const_iterator;
+    auto cbegin () const -> const_iterator;
+    auto cend () const -> const_iterator;
+
+private:
+    struct Slot
+    {
+        Leaf* leaf_;
+        std::size_t index_;
+    };
+
+private:
+    [[nodiscard]]
+    auto new_leaf () -> Leaf*;
+    [[nodiscard]]
+    auto new_inner () -> Inner*;
+    auto delete_leaf (Leaf*) -> void;
+    auto delete_inner (Inner*) -> void;
+    auto delete_subtree (Node*) -> void;
+
+    auto lower_index (Key const*, std::size_t, Key const&) const -> std::size_t;
+    auto upper_index (Key const*, std::size_t, Key const&) const -> std::size_t;
+    auto find_leaf (Key const&) const -> Leaf*;
+    auto find_slot (Key const&) const -> Slot;
+    auto first_leaf () const -> Leaf*;
+
+    template<class K, class... Args>
+    auto try_insert (K&&, Args&&...) -> std::pair<iterator, bool>;
+    template<class K, class M>
+    auto insert_or_assign_impl (K&&, M&&) -> std::pair<iterator, bool>;
+    template<class K, class... Args>
+    auto insert_at (Leaf*, std::size_t, K&&, Args&&...) -> Slot;
+    template<class K, class... Args>
+    auto split_leaf (Leaf*, std::size_t, K&&, Args&&...) -> Slot;
+    auto link_split (Node*, Key const&, Node*, bool, Inner*) -> void;
+    auto inner_insert (Inner*, std::size_t, Key&&, Node*) -> void;
+
+    auto erase_at (Slot) -> Slot;
+    auto rebalance_leaf (Leaf*, std::size_t) -> Slot;
+    auto rebalance_inner (Inner*) -> void;
+    auto merge_leaves (Leaf*, Leaf*) -> void;
+    auto merge_inners (Inner*, Inner*) -> void;
+    auto inner_erase (Inner*, std::size_t) -> void;
+    auto set_son (Inner*, std::size_t, Node*) -> void;
+
+    template<class U, class... Args>
+    static auto array_insert (U*, std::size_t, std::size_t, Args&&...) -> void;
+    template<class U>
+    static auto array_erase (U*, std::size_t, std::size_t) -> void;
+    template<class U>
+    static auto array_move (U*, std::size_t, U*) -> void;
+
+private:
+    using ttt          = std::allocator_traits<Allocator>;
+    using leaf_traits  = typename ttt::template rebind_traits<Leaf>;
+    using leaf_alloc   = typename ttt::template rebind_alloc<Leaf>;
+    using inner_traits = typename ttt::template rebind_traits<Inner>;
+    using inner_alloc  = typename ttt::template rebind_alloc<Inner>;
+
+private:
+    Node*       root_;
+    std::size_t size_;
+    [[no_unique_address]]
+    Allocator   alloc_;
+    [[no_unique_address]]
+    Compare     cmp_;
+};
+
+// btree public api:
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::insert
+    (value_type const& v) -> std::pair<iterator, bool>
+{
+    return this->try_insert(v.first, v.second);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::insert
+    (value_type&& v) -> std::pair<iterator, bool>
+{
+    return this->try_insert(v.first, std::move(v.second));
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class M>
+auto BTree<Key, T, Compare, Allocator>::insert_or_assign
+    (key_type const& k, M&& m) -> std::pair<iterator, bool>
+{
+    return this->insert_or_assign_impl(k, std::forward<M>(m));
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class M>
+auto BTree<Key, T, Compare, Allocator>::insert_or_assign
+    (key_type&& k, M&& m) -> std::pair<iterator, bool>
+{
+    return this->insert_or_assign_impl(std::move(k), std::forward<M>(m));
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class... Args>
+auto BTree<Key, T, Compare, Allocator>::try_emplace
+    (Key const& k, Args&&... as) -> std::pair<iterator, bool>
+{
+    return this->try_insert(k, std::forward<Args>(as)...);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class... Args>
+auto BTree<Key, T, Compare, Allocator>::try_emplace
+    (Key&& k, Args&&... as) -> std::pair<iterator, bool>
+{
+    return this->try_insert(std::move(k), std::forward<Args>(as)...);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class... Args>
+auto BTree<Key, T, Compare, Allocator>::emplace
+    (Args&&... as) -> std::pair<iterator, bool>
+{
+    auto v = value_type(std::forward<Args>(as)...);
+    return this->try_insert(v.first, std::move(v.second));
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::find
+    (key_type const& k) -> iterator
+{
+    auto const [leaf, index] = this->find_slot(k);
+    return iterator(leaf, index);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::find
+    (key_type const& k) const -> const_iterator
+{
+    auto const [leaf, index] = this->find_slot(k);
+    return const_iterator(leaf, index);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::lookup
+    (key_type const& k) -> mapped_type*
+{
+    auto const [leaf, index] = this->find_slot(k);
+    return leaf ? &leaf->values_[index] : nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::lookup
+    (key_type const& k) const -> mapped_type const*
+{
+    auto const [leaf, index] = this->find_slot(k);
+    return leaf ? &leaf->values_[index] : nullptr;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::erase
+    (iterator const it) -> iterator
+{
+    auto const [leaf, index] = this->erase_at({it.leaf_, it.index_});
+    return iterator(leaf, index);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::erase
+    (const_iterator const it) -> iterator
+{
+    auto const [leaf, index] = this->erase_at({it.leaf_, it.index_});
+    return iterator(leaf, index);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::erase
+    (Key const& k) -> std::size_t
+{
+    auto const slot = this->find_slot(k);
+    if (not slot.leaf_)
+    {
+        return 0;
+    }
+    this->erase_at(slot);
+    return 1;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::BTree
+    () :
+    root_  (nullptr),
+    size_  (0),
+    alloc_ (),
+    cmp_   ()
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::BTree
+    (BTree const& o) :
+    root_  (nullptr),
+    size_  (0),
+    alloc_ (ttt::select_on_container_copy_construction(o.alloc_)),
+    cmp_   (o.cmp_)
+{
+    if (o.empty())
+    {
+        return;
+    }
+
+    // Elements come in order so each one is appended to the last leaf,
+    // which keeps all but the rightmost nodes full.
+    try
+    {
+        auto leaf = this->new_leaf();
+        root_ = leaf;
+        for (auto const& [k, v] : o)
+        {
+            leaf = this->insert_at(leaf, leaf->count_, k, v).leaf_;
+        }
+    }
+    catch (...)
+    {
+        if (root_)
+        {
+            this->delete_subtree(root_);
+        }
+        throw;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::BTree
+    (BTree&& o) :
+    root_  (std::exchange(o.root_, nullptr)),
+    size_  (std::exchange(o.size_, 0)),
+    alloc_ (std::move(o.alloc_)),
+    cmp_   (std::move(o.cmp_))
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::~BTree
+    ()
+{
+    if (root_)
+    {
+        this->delete_subtree(root_);
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::operator=
+    (BTree o) -> BTree&
+{
+    this->swap(o);
+    return *this;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::swap
+    (BTree& o) -> void
+{
+    using std::swap;
+    swap(root_, o.root_);
+    swap(size_, o.size_);
+    swap(alloc_, o.alloc_);
+    swap(cmp_, o.cmp_);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::size
+    () const -> std::size_t
+{
+    return size_;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::ssize
+    () const -> std::ptrdiff_t
+{
+    return static_cast<std::ptrdiff_t>(size_);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::empty
+    () const -> bool
+{
+    return 0 == this->size();
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::begin
+    () -> iterator
+{
+    return iterator(this->first_leaf(), 0);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::end
+    () -> iterator
+{
+    return iterator();
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::begin
+    () const -> const_iterator
+{
+    return const_iterator(this->first_leaf(), 0);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::end
+    () const -> const_iterator
+{
+    return const_iterator();
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::cbegin
+    () const -> const_iterator
+{
+    return const_iterator(this->first_leaf(), 0);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::cend
+    () const -> const_iterator
+{
+    return const_iterator();
+}
+
+// btree private api:
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::new_leaf
+    () -> Leaf*
+{
+    auto alloc = leaf_alloc(alloc_);
+    auto const p = leaf_traits::allocate(alloc, 1);
+    leaf_traits::construct(alloc, p);
+    return p;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::new_inner
+    () -> Inner*
+{
+    auto alloc = inner_alloc(alloc_);
+    auto const p = inner_traits::allocate(alloc, 1);
+    inner_traits::construct(alloc, p);
+    return p;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::delete_leaf
+    (Leaf* const p) -> void
+{
+    auto alloc = leaf_alloc(alloc_);
+    leaf_traits::destroy(alloc, p);
+    leaf_traits::deallocate(alloc, p, 1);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::delete_inner
+    (Inner* const p) -> void
+{
+    auto alloc = inner_alloc(alloc_);
+    inner_traits::destroy(alloc, p);
+    inner_traits::deallocate(alloc, p, 1);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::delete_subtree
+    (Node* const node) -> void
+{
+    if (node->isLeaf_)
+    {
+        auto const leaf = static_cast<Leaf*>(node);
+        std::destroy(leaf->keys_, leaf->keys_ + leaf->count_);
+        std::destroy(leaf->values_, leaf->values_ + leaf->count_);
+        this->delete_leaf(leaf);
+    }
+    else
+    {
+        auto const inner = static_cast<Inner*>(node);
+        for (auto i = std::size_t(0); i <= inner->count_; ++i)
+        {
+            this->delete_subtree(inner->sons_[i]);
+        }
+        std::destroy(inner->keys_, inner->keys_ + inner->count_);
+        this->delete_inner(inner);
+    }
+
+    if (node == root_)
+    {
+        root_ = nullptr;
+        size_ = 0;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::lower_index
+    (Key const* const keys, std::size_t const count, Key const& key) const -> std::size_t
+{
+    if constexpr (std::is_arithmetic_v<Key>)
+    {
+        // Counting instead of searching has no branches to mispredict and
+        // vectorizes.
+        auto index = std::size_t(0);
+        for (auto i = std::size_t(0); i < count; ++i)
+        {
+            index += static_cast<std::size_t>(cmp_(keys[i], key));
+        }
+        return index;
+    }
+    else
+    {
+        auto const it = std::partition_point(keys, keys + count, [this, &key](Key const& k)
+        {
+            return cmp_(k, key);
+        });
+        return static_cast<std::size_t>(it - keys);
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::upper_index
+    (Key const* const keys, std::size_t const count, Key const& key) const -> std::size_t
+{
+    if constexpr (std::is_arithmetic_v<Key>)
+    {
+        auto index = std::size_t(0);
+        for (auto i = std::size_t(0); i < count; ++i)
+        {
+            index += static_cast<std::size_t>(not cmp_(key, keys[i]));
+        }
+        return index;
+    }
+    else
+    {
+        auto const it = std::partition_point(keys, keys + count, [this, &key](Key const& k)
+        {
+            return not cmp_(key, k);
+        });
+        return static_cast<std::size_t>(it - keys);
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::find_leaf
+    (Key const& key) const -> Leaf*
+{
+    auto node = root_;
+    while (not node->isLeaf_)
+    {
+        auto const inner = static_cast<Inner*>(node);
+        node = inner->sons_[this->upper_index(inner->keys_, inner->count_, key)];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::find_slot
+    (Key const& key) const -> Slot
+{
+    if (not root_)
+    {
+        return {nullptr, 0};
+    }
+
+    auto const leaf = this->find_leaf(key);
+    auto const index = this->lower_index(leaf->keys_, leaf->count_, key);
+    if (index < leaf->count_ && not cmp_(key, leaf->keys_[index]))
+    {
+        return {leaf, index};
+    }
+    return {nullptr, 0};
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::first_leaf
+    () const -> Leaf*
+{
+    if (this->empty())
+    {
+        return nullptr;
+    }
+
+    auto node = root_;
+    while (not node->isLeaf_)
+    {
+        node = static_cast<Inner*>(node)->sons_[0];
+    }
+    return static_cast<Leaf*>(node);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class K, class... Args>
+auto BTree<Key, T, Compare, Allocator>::try_insert
+    (K&& k, Args&&... as) -> std::pair<iterator, bool>
+{
+    if (not root_)
+    {
+        root_ = this->new_leaf();
+    }
+
+    auto const leaf = this->find_leaf(k);
+    auto const index = this->lower_index(leaf->keys_, leaf->count_, k);
+    if (index < leaf->count_ && not cmp_(k, leaf->keys_[index]))
+    {
+        return {iterator(leaf, index), false};
+    }
+
+    auto const slot = this->insert_at(
+        leaf,
+        index,
+        std::forward<K>(k),
+        std::forward<Args>(as)...
+    );
+    return {iterator(slot.leaf_, slot.index_), true};
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class K, class M>
+auto BTree<Key, T, Compare, Allocator>::insert_or_assign_impl
+    (K&& k, M&& m) -> std::pair<iterator, bool>
+{
+    auto [it, isIn] = this->try_insert(std::forward<K>(k), std::forward<M>(m));
+
+    if (isIn)
+    {
+        return {it, true};
+    }
+
+    it.leaf_->values_[it.index_] = std::forward<M>(m);
+    return {it, false};
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class K, class... Args>
+auto BTree<Key, T, Compare, Allocator>::insert_at
+    (Leaf* const leaf, std::size_t const index, K&& key, Args&&... as) -> Slot
+{
+    if (leaf->count_ == CAPACITY)
+    {
+        return this->split_leaf(
+            leaf, index, std::forward<K>(key), std::forward<Args>(as)...
+        );
+    }
+
+    array_insert(leaf->keys_, leaf->count_, index, std::forward<K>(key));
+    try
+    {
+        array_insert(
+            leaf->values_, leaf->count_, index, std::forward<Args>(as)...
+        );
+    }
+    catch (...)
+    {
+        array_erase(leaf->keys_, leaf->count_ + 1, index);
+        throw;
+    }
+    ++leaf->count_;
+    ++size_;
+    return {leaf, index};
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class K, class... Args>
+auto BTree<Key, T, Compare, Allocator>::split_leaf
+    (Leaf* const leaf, std::size_t const index, K&& key, Args&&... as) -> Slot
+{
+    // Appending to the last leaf, e.g. ascending keys, leaves it full
+    // instead of half empty.
+    auto const append = index == CAPACITY && not leaf->next_;
+    auto const half = append ? CAPACITY : CAPACITY / 2;
+
+    // Allocate new nodes for all the full ancestors up front so that
+    // a failed allocation leaves the tree untouched. Spare nodes are
+    // linked through their parent_.
+    auto const right = this->new_leaf();
+    auto spare = static_cast<Inner*>(nullptr);
+    try
+    {
+        auto parent = leaf->parent_;
+        while (parent && parent->count_ == CAPACITY)
+        {
+            auto const inner = this->new_inner();
+            inner->parent_ = spare;
+            spare = inner;
+            parent = parent->parent_;
+        }
+
+        if (not parent)
+        {
+            auto const inner = this->new_inner();
+            inner->parent_ = spare;
+            spare = inner;
+        }
+    }
+    catch (...)
+    {
+        this->delete_leaf(right);
+        while (spare)
+        {
+            this->delete_inner(std::exchange(spare, spare->parent_));
+        }
+        throw;
+    }
+
+    array_move(leaf->keys_ + half, CAPACITY - half, right->keys_);
+    array_move(leaf->values_ + half, CAPACITY - half, right->values_);
+    right->count_ = CAPACITY - half;
+    leaf->count_ = half;
+    right->next_ = leaf->next_;
+    leaf->next_ = right;
+
+    // The element is constructed in its slot. If that or the copy of the
+    // separator in link_split throws, the split is undone.
+    auto slot = Slot {nullptr, 0};
+    try
+    {
+        slot = index < half
+            ? this->insert_at(
+                  leaf, index, std::forward<K>(key), std::forward<Args>(as)...
+              )
+            : this->insert_at(
+                  right,
+                  index - half,
+                  std::forward<K>(key),
+                  std::forward<Args>(as)...
+              );
+
+        // The first key of the right leaf separates the two leaves.
+        this->link_split(leaf, right->keys_[0], right, append, spare);
+    }
+    catch (...)
+    {
+        if (slot.leaf_)
+        {
+            array_erase(slot.leaf_->keys_, slot.leaf_->count_, slot.index_);
+            array_erase(slot.leaf_->values_, slot.leaf_->count_, slot.index_);
+            --slot.leaf_->count_;
+            --size_;
+        }
+        array_move(right->keys_, right->count_, leaf->keys_ + half);
+        array_move(right->values_, right->count_, leaf->values_ + half);
+        leaf->count_ = CAPACITY;
+        leaf->next_ = right->next_;
+        right->count_ = 0;
+        this->delete_leaf(right);
+        while (spare)
+        {
+            this->delete_inner(std::exchange(spare, spare->parent_));
+        }
+        throw;
+    }
+    return slot;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::link_split
+    (Node* left, Key const& key, Node* right, bool const append, Inner* spare) -> void
+{
+    // Only the copy may throw, before anything is linked.
+    auto separator = key;
+    for (;;)
+    {
+        auto const parent = left->parent_;
+        if (not parent)
+        {
+            auto const root = spare;
+            root->parent_ = nullptr;
+            std::construct_at(root->keys_, std::move(separator));
+            root->count_ = 1;
+            this->set_son(root, 0, left);
+            this->set_son(root, 1, right);
+            root_ = root;
+            return;
+        }
+
+        auto const position = left->position_;
+        if (parent->count_ < CAPACITY)
+        {
+            this->inner_insert(parent, position, std::move(separator), right);
+            return;
+        }
+
+        // The middle key of the full parent goes one level up.
+        auto const sibling = std::exchange(spare, spare->parent_);
+        sibling->parent_ = nullptr;
+        auto const half = append ? CAPACITY - 1 : CAPACITY / 2;
+        auto up = Key(std::move(parent->keys_[half]));
+        std::destroy_at(parent->keys_ + half);
+        array_move(parent->keys_ + half + 1, CAPACITY - half - 1, sibling->keys_);
+        for (auto i = half + 1; i <= CAPACITY; ++i)
+        {
+            this->set_son(sibling, i - half - 1, parent->sons_[i]);
+        }
+        sibling->count_ = CAPACITY - half - 1;
+        parent->count_ = half;
+
+        if (position <= half)
+        {
+            this->inner_insert(parent, position, std::move(separator), right);
+        }
+        else
+        {
+            this->inner_insert(sibling, position - half - 1, std::move(separator), right);
+        }
+
+        separator = std::move(up);
+        left = parent;
+        right = sibling;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::inner_insert
+    (Inner* const node, std::size_t const position, Key&& key, Node* const son) -> void
+{
+    array_insert(node->keys_, node->count_, position, std::move(key));
+    for (auto i = node->count_ + std::size_t(1); i > position + 1; --i)
+    {
+        this->set_son(node, i, node->sons_[i - 1]);
+    }
+    this->set_son(node, position + 1, son);
+    ++node->count_;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::erase_at
+    (Slot const slot) -> Slot
+{
+    auto const leaf = slot.leaf_;
+    array_erase(leaf->keys_, leaf->count_, slot.index_);
+    array_erase(leaf->values_, leaf->count_, slot.index_);
+    --leaf->count_;
+    --size_;
+
+    auto next = Slot {leaf, slot.index_};
+    if (leaf == root_)
+    {
+        if (leaf->count_ == 0)
+        {
+            this->delete_leaf(leaf);
+            root_ = nullptr;
+            return {nullptr, 0};
+        }
+    }
+    else if (leaf->count_ < MIN_COUNT)
+    {
+        next = this->rebalance_leaf(leaf, slot.index_);
+    }
+
+    if (next.index_ == next.leaf_->count_)
+    {
+        return {next.leaf_->next_, 0};
+    }
+    return next;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::rebalance_leaf
+    (Leaf* const leaf, std::size_t const index) -> Slot
+{
+    auto const parent = leaf->parent_;
+    auto const position = leaf->position_;
+    if (position > 0)
+    {
+        auto const left = static_cast<Leaf*>(parent->sons_[position - 1]);
+        if (left->count_ + leaf->count_ <= CAPACITY)
+        {
+            auto const offset = left->count_;
+            this->merge_leaves(left, leaf);
+            this->rebalance_inner(parent);
+            return {left, offset + index};
+        }
+
+        auto const last = left->count_ - std::size_t(1);
+        array_insert(leaf->keys_, leaf->count_, 0, std::move(left->keys_[last]));
+        array_insert(leaf->values_, leaf->count_, 0, std::move(left->values_[last]));
+        std::destroy_at(left->keys_ + last);
+        std::destroy_at(left->values_ + last);
+        --left->count_;
+        ++leaf->count_;
+        parent->keys_[position - 1] = leaf->keys_[0];
+        return {leaf, index + 1};
+    }
+
+    auto const right = static_cast<Leaf*>(parent->sons_[1]);
+    if (leaf->count_ + right->count_ <= CAPACITY)
+    {
+        this->merge_leaves(leaf, right);
+        this->rebalance_inner(parent);
+        return {leaf, index};
+    }
+
+    std::construct_at(leaf->keys_ + leaf->count_, std::move(right->keys_[0]));
+    std::construct_at(leaf->values_ + leaf->count_, std::move(right->values_[0]));
+    array_erase(right->keys_, right->count_, 0);
+    array_erase(right->values_, right->count_, 0);
+    --right->count_;
+    ++leaf->count_;
+    parent->keys_[0] = right->keys_[0];
+    return {leaf, index};
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::rebalance_inner
+    (Inner* node) -> void
+{
+    for (;;)
+    {
+        if (node == root_)
+        {
+            if (node->count_ == 0)
+            {
+                root_ = node->sons_[0];
+                root_->parent_ = nullptr;
+                root_->position_ = 0;
+                this->delete_inner(node);
+            }
+            return;
+        }
+
+        if (node->count_ >= MIN_COUNT)
+        {
+            return;
+        }
+
+        // Merged node also holds the separator from the parent.
+        auto const parent = node->parent_;
+        auto const position = node->position_;
+        if (position > 0)
+        {
+            auto const left = static_cast<Inner*>(parent->sons_[position - 1]);
+            if (left->count_ + node->count_ < CAPACITY)
+            {
+                this->merge_inners(left, node);
+                node = parent;
+                continue;
+            }
+
+            auto const last = left->count_ - std::size_t(1);
+            array_insert(node->keys_, node->count_, 0, std::move(parent->keys_[position - 1]));
+            parent->keys_[position - 1] = std::move(left->keys_[last]);
+            std::destroy_at(left->keys_ + last);
+            for (auto i = node->count_ + std::size_t(1); i > 0; --i)
+            {
+                this->set_son(node, i, node->sons_[i - 1]);
+            }
+            this->set_son(node, 0, left->sons_[last + 1]);
+            --left->count_;
+            ++node->count_;
+            return;
+        }
+
+        auto const right = static_cast<Inner*>(parent->sons_[1]);
+        if (node->count_ + right->count_ < CAPACITY)
+        {
+            this->merge_inners(node, right);
+            node = parent;
+            continue;
+        }
+
+        std::construct_at(node->keys_ + node->count_, std::move(parent->keys_[0]));
+        parent->keys_[0] = std::move(right->keys_[0]);
+        array_erase(right->keys_, right->count_, 0);
+        this->set_son(node, node->count_ + std::size_t(1), right->sons_[0]);
+        for (auto i = std::size_t(0); i < right->count_; ++i)
+        {
+            this->set_son(right, i, right->sons_[i + 1]);
+        }
+        --right->count_;
+        ++node->count_;
+        return;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::merge_leaves
+    (Leaf* const left, Leaf* const right) -> void
+{
+    array_move(right->keys_, right->count_, left->keys_ + left->count_);
+    array_move(right->values_, right->count_, left->values_ + left->count_);
+    left->count_ += right->count_;
+    left->next_ = right->next_;
+    this->inner_erase(left->parent_, left->position_);
+    this->delete_leaf(right);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::merge_inners
+    (Inner* const left, Inner* const right) -> void
+{
+    auto const parent = left->parent_;
+    auto const offset = left->count_ + std::size_t(1);
+    std::construct_at(left->keys_ + left->count_, std::move(parent->keys_[left->position_]));
+    array_move(right->keys_, right->count_, left->keys_ + offset);
+    for (auto i = std::size_t(0); i <= right->count_; ++i)
+    {
+        this->set_son(left, offset + i, right->sons_[i]);
+    }
+    left->count_ += right->count_ + 1;
+    this->inner_erase(parent, left->position_);
+    this->delete_inner(right);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::inner_erase
+    (Inner* const node, std::size_t const index) -> void
+{
+    array_erase(node->keys_, node->count_, index);
+    for (auto i = index + 1; i < node->count_; ++i)
+    {
+        this->set_son(node, i, node->sons_[i + 1]);
+    }
+    --node->count_;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+auto BTree<Key, T, Compare, Allocator>::set_son
+    (Inner* const node, std::size_t const position, Node* const son) -> void
+{
+    node->sons_[position] = son;
+    son->parent_ = node;
+    son->position_ = static_cast<std::uint16_t>(position);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class U, class... Args>
+auto BTree<Key, T, Compare, Allocator>::array_insert
+    (U* const data, std::size_t const count, std::size_t const index, Args&&... as) -> void
+{
+    if (index == count)
+    {
+        std::construct_at(data + count, std::forward<Args>(as)...);
+        return;
+    }
+
+    std::construct_at(data + count, std::move(data[count - 1]));
+    std::move_backward(data + index, data + count - 1, data + count);
+    std::destroy_at(data + index);
+    try
+    {
+        std::construct_at(data + index, std::forward<Args>(as)...);
+    }
+    catch (...)
+    {
+        // Close the gap so that the array stays contiguous.
+        std::construct_at(data + index, std::move(data[index + 1]));
+        std::move(data + index + 2, data + count + 1, data + index + 1);
+        std::destroy_at(data + count);
+        throw;
+    }
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class U>
+auto BTree<Key, T, Compare, Allocator>::array_erase
+    (U* const data, std::size_t const count, std::size_t const index) -> void
+{
+    std::move(data + index + 1, data + count, data + index);
+    std::destroy_at(data + count - 1);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<class U>
+auto BTree<Key, T, Compare, Allocator>::array_move
+    (U* const data, std::size_t const count, U* const dest) -> void
+{
+    std::uninitialized_move(data, data + count, dest);
+    std::destroy(data, data + count);
+}
+
+// btree::node:
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::Node::Node
+    (bool const isLeaf) :
+    isLeaf_ (isLeaf)
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::Leaf::Leaf
+    () :
+    Node (true)
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::Leaf::~Leaf
+    ()
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::Inner::Inner
+    () :
+    Node (false)
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+BTree<Key, T, Compare, Allocator>::Inner::~Inner
+    ()
+{
+}
+
+// btree::btree_iterator:
+
+template<class Key, class T, class Compare, class Allocator>
+template<bool IsConst>
+BTree<Key, T, Compare, Allocator>::BTreeIterator<IsConst>::BTreeIterator
+    (Leaf* const leaf, std::size_t const index) :
+    leaf_  (leaf),
+    index_ (index)
+{
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<bool IsConst>
+auto BTree<Key, T, Compare, Allocator>::BTreeIterator<IsConst>::operator*
+    () const -> reference
+{
+    return reference(leaf_->keys_[index_], leaf_->values_[index_]);
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<bool IsConst>
+auto BTree<Key, T, Compare, Allocator>::BTreeIterator<IsConst>::operator++
+    () -> BTreeIterator&
+{
+    if (++index_ == leaf_->count_)
+    {
+        leaf_ = leaf_->next_;
+        index_ = 0;
+    }
+    return *this;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<bool IsConst>
+auto BTree<Key, T, Compare, Allocator>::BTreeIterator<IsConst>::operator==
+    (BTreeIterator const& other) const -> bool
+{
+    return leaf_ == other.leaf_ && index_ == other.index_;
+}
+
+template<class Key, class T, class Compare, class Allocator>
+template<bool IsConst>
+auto BTree<Key, T, Compare, Allocator>::BTreeIterator<IsConst>::operator!=
+    (BTreeIterator const& other) const -> bool
+{
+    return not (*this == other);
+}
+} // namespace idril
+
+#endif
@@ -1,3 +1,5 @@
+#ifndef LIBIDRIL_IDRIL_COMMON_HPP
+#define LIBIDRIL_IDRIL_COMMON_HPP
 
 namespace idril::details
 {
@@ -58,4 +60,6 @@ struct PiecewiseConstructTag
 
 // TODO move
 // TODO forward
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,549 @@
+#ifndef LIBIDRIL_INTRUSIVE_PAIRING_HEAP_HPP
+#define LIBIDRIL_INTRUSIVE_PAIRING_HEAP_HPP
+
+#include "idril_common.hpp"
+#include "pairing_heap.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <stdexcept>
+
+namespace idril
+{
+/**
+ *  \brief Links of an element stored in an IntrusivePairingHeap.
+ *
+ *  Copies of a hook are unlinked so that copying an element never copies
+ *  its position in a heap.
+ */
+class PairingHook
+{
+public:
+    template<class Node, class NodeLess>
+    friend struct details::PairingLinker;
+
+    template<class T, class HookTraits, class Compare, class MergeMode>
+    friend class IntrusivePairingHeap;
+
+public:
+    PairingHook() = default;
+
+    PairingHook(PairingHook const&)
+    {
+    }
+
+    auto operator=(PairingHook const&) -> PairingHook&
+    {
+        return *this;
+    }
+
+private:
+    PairingHook* parent_ {nullptr};
+    PairingHook* left_ {nullptr};
+    PairingHook* right_ {nullptr};
+};
+
+/**
+ *  \brief Hook traits for elements derived from PairingHook.
+ *  \tparam T  The type of the elements.
+ */
+template<class T>
+struct PairingBaseHook
+{
+    static auto to_hook(T& value) -> PairingHook*;
+    static auto to_value(PairingHook* hook) -> T&;
+    static auto to_value(PairingHook const* hook) -> T const&;
+};
+
+/**
+ *  \brief Hook traits for elements with PairingHook member.
+ *
+ *  Elements are found from their hooks by the offset of the member, so
+ *  T must be a standard-layout type.
+ *
+ *  \tparam T       The type of the elements.
+ *  \tparam Member  Pointer to the hook member.
+ */
+template<class T, PairingHook T::*Member>
+struct PairingMemberHook
+{
+    static auto to_hook(T& value) -> PairingHook*;
+    static auto to_value(PairingHook* hook) -> T&;
+    static auto to_value(PairingHook const* hook) -> T const&;
+
+private:
+    static auto offset() -> std::ptrdiff_t;
+};
+
+/**
+ *  \brief IntrusivePairingHeap forward declaration.
+ */
+template<
+    class T,
+    class HookTraits = PairingBaseHook<T>,
+    class Compare    = details::less<T>,
+    class MergeMode  = merge_mode::TwoPass>
+class IntrusivePairingHeap;
+
+namespace details
+{
+/**
+ *  \brief Storage of a T that is never constructed.
+ *
+ *  Addresses of its members give offsets of the members within T.
+ *  The lifetime of the T never starts, so naming its members is formally
+ *  undefined behaviour. Compilers lay the members out as in any other T,
+ *  the same assumption Boost.Intrusive makes. offsetof is well defined
+ *  but needs the name of the member, not a pointer to it.
+ */
+template<class T>
+union MemberProbe
+{
+    constexpr MemberProbe() : none_ {}
+    {
+    }
+
+    constexpr ~MemberProbe()
+    {
+    }
+
+    char none_;
+    T value_;
+};
+
+/**
+ *  \brief Probe used by PairingMemberHook.
+ */
+template<class T>
+constinit inline MemberProbe<T> memberProbe {};
+
+/**
+ *  \brief Compares hooks by the elements that contain them.
+ */
+template<class T, class HookTraits, class Compare>
+struct HookLess
+{
+    auto operator()(PairingHook const* lhs, PairingHook const* rhs) const
+        -> bool;
+};
+} // namespace details
+
+/**
+ *  \brief Pairing heap of elements that contain their own links.
+ *
+ *  The heap neither allocates nor copies elements, it only links their
+ *  hooks. Elements are owned by the user and must stay at the same address
+ *  while they are in the heap. An element can be in at most one heap at
+ *  a time. The element itself serves as a handle.
+ *
+ *  If A < B i.e., Compare()(A, B) == true then A has higher priority than B.
+ *
+ *  \tparam T           The type of the stored elements.
+ *  \tparam HookTraits  PairingBaseHook or PairingMemberHook.
+ *  \tparam Compare     A type providing a strict weak ordering.
+ *  \tparam MergeMode   See the merge_mode namespace. Lazy insertion
+ *                      of AuxiliaryTwoPass is not supported.
+ */
+template<class T, class HookTraits, class Compare, class MergeMode>
+class IntrusivePairingHeap
+{
+    static_assert(
+        not std::is_same_v<MergeMode, merge_mode::AuxiliaryTwoPass>,
+        "AuxiliaryTwoPass is only supported by PairingHeap."
+    );
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = T const&;
+
+public:
+    /**
+     *  \brief Default constructor
+     */
+    IntrusivePairingHeap() = default;
+
+    /**
+     *  \brief Deleted copy constructor, elements are owned by the user
+     */
+    IntrusivePairingHeap(IntrusivePairingHeap const&) = delete;
+
+    /**
+     *  \brief Move constructor
+     *  \param other other heap to be moved from
+     */
+    IntrusivePairingHeap(IntrusivePairingHeap&& other) noexcept;
+
+    /**
+     *  \brief Move assignment operator
+     *  \param other heap to assign into this one
+     *  \return reference to this heap
+     */
+    auto operator=(IntrusivePairingHeap other) noexcept
+        -> IntrusivePairingHeap&;
+
+    /**
+     *  \brief Links \p value into the heap
+     *  \param value element that is not in any heap
+     */
+    auto insert(reference value) -> void;
+
+    /**
+     *  \brief Unlinks the element with the highest priority
+     */
+    auto delete_min() -> void;
+
+    /**
+     *  \brief Accesses the element with the highest priority
+     *  \return reference to the element with highest priority
+     */
+    auto find_min() -> reference;
+
+    /**
+     *  \brief Accesses the element with the highest priority
+     *  \return reference to the element with highest priority
+     */
+    auto find_min() const -> const_reference;
+
+    /**
+     *  \brief Adjusts position of the element whose priority has increased
+     *
+     *  Behavior is undefined if the priority decreased!
+     *
+     *  \param value element with updated priority
+     */
+    auto decrease_key(reference value) -> void;
+
+    /**
+     *  \brief Adjusts position of the element whose priority has decreased
+     *
+     *  Works for any change of the priority but decrease_key is cheaper
+     *  if it has increased.
+     *
+     *  \param value element with updated priority
+     */
+    auto increase_key(reference value) -> void;
+
+    /**
+     *  \brief Unlinks the element from the heap
+     *  \param value element to be removed
+     */
+    auto erase(reference value) -> void;
+
+    /**
+     *  \brief Melds the other heap into this one
+     *  \param other other heap to be melded into this one
+     *  \return reference to this heap
+     */
+    auto meld(IntrusivePairingHeap other) -> IntrusivePairingHeap&;
+
+    /**
+     *  \brief Swap this heap with the \p other
+     *  \param other other heap to be swapped with this one
+     */
+    auto swap(IntrusivePairingHeap& other) noexcept -> void;
+
+    /**
+     *  \brief Checks if the heap is empty
+     *  \return bool value indication whether this heap is empty
+     */
+    auto empty() const -> bool;
+
+    /**
+     *  \brief Returns the number of elements in the heap
+     *  \return number of elements in the heap
+     */
+    auto size() const -> size_type;
+
+    /**
+     *  \brief Forgets all elements without touching their hooks
+     *
+     *  Hooks of the elements must be reset, e.g. by assigning a new
+     *  PairingHook, before they are inserted again.
+     */
+    auto clear() -> void;
+
+private:
+    using hook_t   = PairingHook;
+    using linker_t = details::
+        PairingLinker<hook_t, details::HookLess<T, HookTraits, Compare>>;
+
+private:
+    auto empty_check() const -> void;
+    auto remove_sons(hook_t* hook) -> void;
+
+private:
+    hook_t* root_ {nullptr};
+    size_type size_ {0};
+};
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto swap(
+    IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>& lhs,
+    IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>& rhs
+) noexcept -> void;
+
+/// definitions:
+
+// Hook traits definitions:
+
+template<class T>
+auto PairingBaseHook<T>::to_hook(T& value) -> PairingHook*
+{
+    return static_cast<PairingHook*>(&value);
+}
+
+template<class T>
+auto PairingBaseHook<T>::to_value(PairingHook* const hook) -> T&
+{
+    return static_cast<T&>(*hook);
+}
+
+template<class T>
+auto PairingBaseHook<T>::to_value(PairingHook const* const hook) -> T const&
+{
+    return static_cast<T const&>(*hook);
+}
+
+template<class T, PairingHook T::*Member>
+auto PairingMemberHook<T, Member>::to_hook(T& value) -> PairingHook*
+{
+    return &(value.*Member);
+}
+
+template<class T, PairingHook T::*Member>
+auto PairingMemberHook<T, Member>::to_value(PairingHook* const hook) -> T&
+{
+    auto* const bytes = reinterpret_cast<std::byte*>(hook);
+    return *reinterpret_cast<T*>(bytes - offset());
+}
+
+template<class T, PairingHook T::*Member>
+auto PairingMemberHook<T, Member>::to_value(PairingHook const* const hook)
+    -> T const&
+{
+    auto const* const bytes = reinterpret_cast<std::byte const*>(hook);
+    return *reinterpret_cast<T const*>(bytes - offset());
+}
+
+template<class T, PairingHook T::*Member>
+auto PairingMemberHook<T, Member>::offset() -> std::ptrdiff_t
+{
+    static_assert(
+        std::is_standard_layout_v<T>,
+        "PairingMemberHook requires a standard-layout type."
+    );
+
+    // Address of the probe is a link-time constant so compilers fold the
+    // offset into a constant.
+    auto const& probe = details::memberProbe<T>.value_;
+    return reinterpret_cast<std::byte const*>(&(probe.*Member))
+         - reinterpret_cast<std::byte const*>(&probe);
+}
+
+namespace details
+{
+template<class T, class HookTraits, class Compare>
+auto HookLess<T, HookTraits, Compare>::operator()(
+    PairingHook const* const lhs, PairingHook const* const rhs
+) const -> bool
+{
+    return Compare()(HookTraits::to_value(lhs), HookTraits::to_value(rhs));
+}
+} // namespace details
+
+// IntrusivePairingHeap definitions:
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::IntrusivePairingHeap(
+    IntrusivePairingHeap&& other
+) noexcept :
+    root_(std::exchange(other.root_, nullptr)),
+    size_(std::exchange(other.size_, 0))
+{
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::operator=(
+    IntrusivePairingHeap other
+) noexcept -> IntrusivePairingHeap&
+{
+    this->swap(other);
+    return *this;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::insert(
+    reference value
+) -> void
+{
+    auto* const hook = HookTraits::to_hook(value);
+    root_            = root_ ? linker_t::pair(root_, hook) : hook;
+    ++size_;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::delete_min()
+    -> void
+{
+    this->empty_check();
+    auto* const oldRoot = std::exchange(root_, nullptr);
+    this->remove_sons(oldRoot);
+    --size_;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::find_min()
+    -> reference
+{
+    this->empty_check();
+    return HookTraits::to_value(root_);
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::find_min() const
+    -> const_reference
+{
+    this->empty_check();
+    return HookTraits::to_value(static_cast<hook_t const*>(root_));
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::decrease_key(
+    reference value
+) -> void
+{
+    auto* const hook = HookTraits::to_hook(value);
+    if (hook == root_)
+    {
+        return;
+    }
+
+    linker_t::cut(hook);
+    root_ = linker_t::pair(hook, root_);
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::increase_key(
+    reference value
+) -> void
+{
+    auto* const hook = HookTraits::to_hook(value);
+    if (hook == root_)
+    {
+        root_ = nullptr;
+    }
+    else
+    {
+        linker_t::cut(hook);
+    }
+
+    this->remove_sons(hook);
+    root_ = root_ ? linker_t::pair(root_, hook) : hook;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::erase(
+    reference value
+) -> void
+{
+    auto* const hook = HookTraits::to_hook(value);
+    if (hook == root_)
+    {
+        this->delete_min();
+        return;
+    }
+
+    linker_t::cut(hook);
+    this->remove_sons(hook);
+    --size_;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::meld(
+    IntrusivePairingHeap other
+) -> IntrusivePairingHeap&
+{
+    if (other.empty())
+    {
+        return *this;
+    }
+
+    root_ = root_ ? linker_t::pair(root_, other.root_) : other.root_;
+    size_ += other.size_;
+    other.root_ = nullptr;
+    other.size_ = 0;
+    return *this;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::swap(
+    IntrusivePairingHeap& other
+) noexcept -> void
+{
+    using std::swap;
+    swap(root_, other.root_);
+    swap(size_, other.size_);
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::empty() const
+    -> bool
+{
+    return 0 == this->size();
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::size() const
+    -> size_type
+{
+    return size_;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::clear() -> void
+{
+    root_ = nullptr;
+    size_ = 0;
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::empty_check()
+    const -> void
+{
+    if (this->empty())
+    {
+        throw std::out_of_range("Heap is empty!");
+    }
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>::remove_sons(
+    hook_t* const hook
+) -> void
+{
+    // Merges sons of the unlinked hook into the root, the hook can be
+    // inserted again afterwards.
+    if (hook->left_)
+    {
+        auto* const sons = std::exchange(hook->left_, nullptr);
+        sons->parent_    = nullptr;
+        auto* const tree = linker_t::merge(sons, MergeMode());
+        root_            = root_ ? linker_t::pair(root_, tree) : tree;
+    }
+}
+
+template<class T, class HookTraits, class Compare, class MergeMode>
+auto swap(
+    IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>& lhs,
+    IntrusivePairingHeap<T, HookTraits, Compare, MergeMode>& rhs
+) noexcept -> void
+{
+    lhs.swap(rhs);
+}
+} // namespace idril
+
+#endif
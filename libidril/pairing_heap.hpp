@@ -2,8 +2,14 @@
 #define LIBIDRIL_PAIRING_HEAP_HPP
 
 #include "idril_common.hpp"
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <iterator>
 #include <stdexcept>
@@ -25,12 +31,65 @@ struct FifoQueue
 {
 };
 
-// TODO implement and explain
+/**
+ *  \brief Multipass merge.
+ *
+ *  Siblings are paired left to right in repeated passes, each pass
+ *  halving their number, until a single tree remains.
+ */
 struct Hierarchical
 {
 };
+
+/**
+ *  \brief Two-pass merge with lazy insertion.
+ *
+ *  Inserted nodes are only put into an auxiliary list of roots without
+ *  any comparison. The list is merged using multipass and paired with
+ *  the root the next time the minimum is needed.
+ */
+struct AuxiliaryTwoPass
+{
+};
 } // namespace merge_mode
 
+namespace details
+{
+/**
+ *  \brief Linking operations shared by pairing heaps.
+ *
+ *  Trees are binary trees of nodes with parent_, left_ and right_ pointers.
+ *  Left points to the first son and right to the next sibling. Parent
+ *  points to the parent of a first son and to the previous sibling
+ *  otherwise.
+ *
+ *  \tparam Node      The type of the nodes.
+ *  \tparam NodeLess  Stateless function object comparing two nodes.
+ */
+template<class Node, class NodeLess>
+struct PairingLinker
+{
+    static auto pair(Node* lhs, Node* rhs) -> Node*;
+    static auto merge(Node* first, merge_mode::TwoPass) -> Node*;
+    static auto merge(Node* first, merge_mode::FifoQueue) -> Node*;
+    static auto merge(Node* first, merge_mode::Hierarchical) -> Node*;
+    static auto merge(Node* first, merge_mode::AuxiliaryTwoPass) -> Node*;
+    static auto first_pass(Node* first) -> Node*;
+    static auto second_pass(Node* last) -> Node*;
+    static auto cut(Node* node) -> void;
+};
+
+/**
+ *  \brief Compares nodes by their data_ members.
+ */
+template<class Compare>
+struct DataLess
+{
+    template<class Node>
+    auto operator()(Node const* lhs, Node const* rhs) const -> bool;
+};
+} // namespace details
+
 /**
  *  \brief PairingHeap forward declaration.
  */
@@ -70,6 +129,16 @@ private:
  *  
  *  If A < B i.e., Compare()(A, B) == true then A has higher priority than B.
  *
+ *  Nodes of a range (see the range constructor, assign, insert_range and
+ *  emplace_range) are allocated as a single block. Blocks are kept until
+ *  clear, assign or destruction, deleted nodes of a block are only reused
+ *  by the heap. So a heap built from a range holds memory for at least as
+ *  many nodes as the range had.
+ *  Meld takes O(1) time if the other heap has no blocks and O(B) time
+ *  otherwise, B being the number of blocks of both heaps. Once a heap has
+ *  blocks, every removal of an element also takes O(log B) time to find
+ *  whether its node belongs to one of them.
+ *
  *  \tparam T          The type of the stored elements.
  *  \tparam Compare    A type providing a strict weak ordering.
  *  \tparam MergeMode  See the merge_mode namespace above.
@@ -105,7 +174,7 @@ public:
     {
     public:
         using difference_type   = long long;
-        using value_type        = details::type_if<IsConst, T const, T>;
+        using value_type        = details::type_if_t<IsConst, T const, T>;
         using pointer           = value_type*;
         using reference         = value_type&;
         using iterator_category = std::forward_iterator_tag;
@@ -147,6 +216,21 @@ public:
      */
     PairingHeap(Allocator const& alloc = Allocator());
 
+    /**
+     *  \brief Constructs heap from elements in the range [first, last)
+     *
+     *  Nodes for forward ranges are allocated in a single request and
+     *  linked using the FIFO merge.
+     *
+     *  \param first begin of the range
+     *  \param last end of the range
+     *  \param alloc allocator
+     */
+    template<std::input_iterator InputIt>
+    PairingHeap(
+        InputIt first, InputIt last, Allocator const& alloc = Allocator()
+    );
+
     /**
      *  \brief Copy constructor
      *  \param other other heap to be copied
@@ -175,6 +259,14 @@ public:
      */
     auto operator=(PairingHeap other) noexcept -> PairingHeap&;
 
+    /**
+     *  \brief Replaces elements with those in the range [first, last)
+     *  \param first begin of the range
+     *  \param last end of the range
+     */
+    template<std::input_iterator InputIt>
+    auto assign(InputIt first, InputIt last) -> void;
+
     /**
      *  \brief Inserts new element constructing it in-place from \p args
      *  \param args arguments from which the element will be constructed
@@ -197,6 +289,35 @@ public:
      */
     auto insert(value_type&& value) -> handle_type;
 
+    /**
+     *  \brief Inserts copies of \p values
+     *
+     *  Free nodes are reused first, the missing ones are allocated by
+     *  a single request, which adds a block to the heap. New nodes are
+     *  merged together before they are paired with the root.
+     *
+     *  \param values elements to be inserted
+     *  \param handles output for handles to the inserted elements,
+     *  must be at least as long as \p values
+     */
+    auto insert_range(
+        std::span<value_type const> values, std::span<handle_type> handles
+    ) -> void;
+
+    /**
+     *  \brief Inserts new elements constructing each one from \p args
+     *
+     *  Same as insert_range but the i-th element is constructed
+     *  in-place from \p args [i].
+     *
+     *  \param args arguments from which the elements will be constructed
+     *  \param handles output for handles to the inserted elements,
+     *  must be at least as long as \p args
+     */
+    template<class Arg>
+    auto emplace_range(std::span<Arg> args, std::span<handle_type> handles)
+        -> void;
+
     /**
      *  \brief Removes the element with the highest priority
      */
@@ -241,10 +362,35 @@ public:
      */
     auto decrease_key(const_iterator pos) -> void;
 
-    // TODO increase_key
+    /**
+     *  \brief Adjusts position of the element whose priority has decreased
+     *
+     *  The node is cut out, its sons are merged and both are paired with
+     *  the root without any reallocation. Works for any change of the
+     *  priority but decrease_key is cheaper if it has increased.
+     *
+     *  \param handle handle pointing to the element with updated priority
+     */
+    auto increase_key(handle_type handle) -> void;
+
+    /**
+     *  \brief Adjusts position of the element whose priority has decreased
+     *  \param pos iterator pointing to the element with updated priority
+     */
+    auto increase_key(iterator pos) -> void;
+
+    /**
+     *  \brief Adjusts position of the element whose priority has decreased
+     *  \param pos iterator pointing to the element with updated priority
+     */
+    auto increase_key(const_iterator pos) -> void;
 
     /**
      *  \brief Melds the other heap into this one
+     *
+     *  Elements of the other heap are moved one by one if the allocators
+     *  of the heaps compare unequal. Handles to them are invalidated then.
+     *
      *  \param other other heap to be melded into this one
      *  \return reference to this heap
      */
@@ -353,6 +499,24 @@ private:
     using node_allocator =
         typename type_alloc_traits::template rebind_alloc<node_t>;
 
+    static constexpr auto IsLazy
+        = std::is_same_v<MergeMode, merge_mode::AuxiliaryTwoPass>;
+
+    /**
+     *  \brief Nodes allocated by a single request.
+     */
+    struct NodeBlock
+    {
+        node_t* nodes_;
+        size_type count_;
+    };
+
+    using block_allocator =
+        typename type_alloc_traits::template rebind_alloc<NodeBlock>;
+
+    template<class Cmp = Compare>
+    using linker_t = details::PairingLinker<node_t, details::DataLess<Cmp>>;
+
 private:
     template<class... Args>
     auto new_node(Args&&... args) -> node_t*;
@@ -362,6 +526,22 @@ private:
     auto empty_check() const -> void;
     auto deep_copy(node_t* root) -> node_t*;
     auto erase_impl(node_t* node) -> void;
+    auto inc_key_impl(node_t* node) -> void;
+    auto push_aux(node_t* node) -> void;
+    auto is_in_block(node_t* node) const -> bool;
+    auto free_blocks() -> void;
+
+    auto reserve_nodes(size_type count) -> void;
+    auto push_free(node_t* node) -> void;
+
+    template<std::input_iterator InputIt>
+    auto insert_range_impl(InputIt first, InputIt last) -> void;
+
+    template<std::forward_iterator ForwardIt>
+    auto insert_block(
+        ForwardIt first, size_type count, std::span<handle_type> handles
+    ) -> void;
+    auto consolidate() const -> void;
 
     template<class Cmp = Compare>
     auto dec_key_impl(node_t* node) -> void;
@@ -370,20 +550,31 @@ private:
     auto new_node_impl(Args&&... args) -> node_t*;
 
     static auto handle_to_node(handle_type handle) -> node_t*;
+    static auto next_free(node_t* node) -> node_t*&;
+    static auto block_less(NodeBlock const& lhs, NodeBlock const& rhs)
+        -> bool;
 
     template<class Cmp = Compare>
     static auto pair(node_t* lhs, node_t* rhs) -> node_t*;
-    static auto merge(node_t* first) -> node_t*;
-    static auto merge(node_t* first, merge_mode::TwoPass) -> node_t*;
-    static auto merge(node_t* first, merge_mode::FifoQueue) -> node_t*;
-    static auto first_pass(node_t* first) -> node_t*;
-    static auto second_pass(node_t* last) -> node_t*;
+
+    template<class Mode = MergeMode>
+    static auto merge(node_t* first, Mode mode = Mode()) -> node_t*;
 
 private:
     [[no_unique_address]]
     node_allocator alloc_;
-    node_t* root_;
+    // In the lazy mode, siblings of the root form the auxiliary list
+    // which is merged even by const member functions.
+    mutable node_t* root_;
     size_type size_;
+    // Nodes of blocks are never deallocated one by one, deleted
+    // ones are linked through their storage and reused. Blocks
+    // are sorted by address.
+    std::vector<NodeBlock, block_allocator> blocks_;
+    node_t* freeNodes_;
+    // Last free node, valid only if there are any.
+    node_t* freeTail_;
+    size_type freeCount_;
 };
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -411,6 +602,228 @@ struct AlwaysTrueCmp
         return true;
     }
 };
+
+template<class Compare>
+template<class Node>
+auto DataLess<Compare>::operator()(Node const* const lhs, Node const* const rhs)
+    const -> bool
+{
+    return Compare()(lhs->data_, rhs->data_);
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::pair(Node* const lhs, Node* const rhs)
+    -> Node*
+{
+    auto const areOrdered  = NodeLess()(lhs, rhs);
+    auto* const parent     = areOrdered ? lhs : rhs;
+    auto* const son        = areOrdered ? rhs : lhs;
+    auto* const oldLeftSon = parent->left_;
+
+    son->parent_           = parent;
+    son->right_            = oldLeftSon;
+    parent->left_          = son;
+
+    if (oldLeftSon)
+    {
+        oldLeftSon->parent_ = son;
+    }
+
+    return parent;
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::merge(
+    Node* const first, merge_mode::TwoPass
+) -> Node*
+{
+    return second_pass(first_pass(first));
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::merge(
+    Node* first, merge_mode::FifoQueue
+) -> Node*
+{
+    // Use parent pointers to make the queue
+    auto* head    = first;
+    auto* last    = first;
+    first         = first->right_;
+    head->parent_ = nullptr;
+    head->right_  = nullptr;
+
+    auto* next    = static_cast<Node*>(nullptr);
+    while (first)
+    {
+        next           = first->right_;
+        first->right_  = nullptr;
+        first->parent_ = head;
+        head           = first;
+        first          = next;
+    }
+
+    // Perform fifo merge
+    while (head && head->parent_)
+    {
+        auto* const lhs = head;
+        auto* const rhs = head->parent_;
+        head            = head->parent_->parent_;
+        lhs->parent_    = nullptr;
+        rhs->parent_    = nullptr;
+        last->parent_   = pair(lhs, rhs);
+        last            = last->parent_;
+    }
+
+    // The final pair might have been appended behind itself
+    last->parent_ = nullptr;
+    return last;
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::merge(
+    Node* first, merge_mode::Hierarchical
+) -> Node*
+{
+    while (first->right_)
+    {
+        // Single pass, pairs are linked using right pointers
+        auto* head = static_cast<Node*>(nullptr);
+        auto* tail = static_cast<Node*>(nullptr);
+        while (first)
+        {
+            auto* const second = first->right_;
+            auto* const next   = second ? second->right_ : nullptr;
+            first->right_      = nullptr;
+            first->parent_     = nullptr;
+
+            auto* paired       = first;
+            if (second)
+            {
+                second->right_  = nullptr;
+                second->parent_ = nullptr;
+                paired          = pair(first, second);
+            }
+
+            if (tail)
+            {
+                tail->right_    = paired;
+                paired->parent_ = tail;
+            }
+            else
+            {
+                head = paired;
+            }
+
+            tail  = paired;
+            first = next;
+        }
+        first = head;
+    }
+
+    first->parent_ = nullptr;
+    return first;
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::merge(
+    Node* const first, merge_mode::AuxiliaryTwoPass
+) -> Node*
+{
+    return second_pass(first_pass(first));
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::first_pass(Node* first)
+    -> Node*
+{
+    auto* prev   = static_cast<Node*>(nullptr);
+    auto* paired = static_cast<Node*>(nullptr);
+    auto* next   = first;
+    auto* second = first->right_;
+
+    for (;;)
+    {
+        first = next;
+        if (not first)
+        {
+            return prev;
+        }
+
+        second = first->right_;
+        if (second)
+        {
+            next            = second->right_;
+            first->right_   = nullptr;
+            first->parent_  = nullptr;
+            second->right_  = nullptr;
+            second->parent_ = nullptr;
+            paired          = pair(first, second);
+        }
+        else
+        {
+            paired = first;
+            next   = nullptr;
+        }
+
+        if (prev)
+        {
+            prev->right_    = paired;
+            paired->parent_ = prev;
+        }
+        prev = paired;
+
+        if (next)
+        {
+            next->parent_ = nullptr;
+        }
+        else
+        {
+            return prev;
+        }
+    }
+
+    return prev; // TODO toto môže byť null, je to v poriadku?
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::second_pass(Node* last)
+    -> Node*
+{
+    auto* parent  = last->parent_;
+    last->parent_ = nullptr;
+
+    while (parent)
+    {
+        auto const next = parent->parent_;
+        parent->right_  = nullptr;
+        parent->parent_ = nullptr;
+        last            = pair(last, parent);
+        parent          = next;
+    }
+
+    return last;
+}
+
+template<class Node, class NodeLess>
+auto PairingLinker<Node, NodeLess>::cut(Node* const node) -> void
+{
+    if (node->parent_ && node == node->parent_->left_)
+    {
+        node->parent_->left_ = node->right_;
+    }
+    else
+    {
+        node->parent_->right_ = node->right_;
+    }
+
+    if (node->right_)
+    {
+        node->right_->parent_ = node->parent_;
+    }
+
+    node->parent_ = nullptr;
+    node->right_  = nullptr;
+}
 } // namespace details
 
 // PairingNode definition:
@@ -499,17 +912,33 @@ template<class T, class Compare, class MergeMode, class Allocator>
 PairingHeap<T, Compare, MergeMode, Allocator>::PairingHeap(
     Allocator const& alloc
 )
-    : alloc_(alloc), root_(nullptr), size_(0)
+    : alloc_(alloc), root_(nullptr), size_(0), blocks_(alloc_),
+      freeNodes_(nullptr), freeTail_(nullptr), freeCount_(0)
 {
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
+template<std::input_iterator InputIt>
 PairingHeap<T, Compare, MergeMode, Allocator>::PairingHeap(
-    PairingHeap const& other
+    InputIt first, InputIt last, Allocator const& alloc
 )
-    : alloc_(other.alloc_), // TODO
-      root_(this->deep_copy(other)), size_(other.size_)
+    : PairingHeap(alloc)
 {
+    this->insert_range_impl(first, last);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+PairingHeap<T, Compare, MergeMode, Allocator>::PairingHeap(
+    PairingHeap const& other
+)
+    : alloc_(node_alloc_traits::select_on_container_copy_construction(
+          other.alloc_
+      )),
+      root_(nullptr), size_(other.size_), blocks_(alloc_),
+      freeNodes_(nullptr), freeTail_(nullptr), freeCount_(0)
+{
+    // Copying needs the free list to be initialized
+    root_ = this->deep_copy(other.root_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -517,8 +946,13 @@ PairingHeap<T, Compare, MergeMode, Allocator>::PairingHeap(PairingHeap&& other
 ) noexcept
     : alloc_(std::move(other.alloc_)), // TODO
       root_(std::exchange(other.root_, nullptr)),
-      size_(std::exchange(other.size_, 0))
+      size_(std::exchange(other.size_, 0)),
+      blocks_(std::move(other.blocks_)),
+      freeNodes_(std::exchange(other.freeNodes_, nullptr)),
+      freeTail_(std::exchange(other.freeTail_, nullptr)),
+      freeCount_(std::exchange(other.freeCount_, 0))
 {
+    other.blocks_.clear();
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -541,9 +975,9 @@ PairingHeap<T, Compare, MergeMode, Allocator>::~PairingHeap()
 
         if (next != nullptr)
         {
-            while (node->left_ || node->right_)
+            while (next->left_ || next->right_)
             {
-                node = node->left_ ? node->left_ : node->right_;
+                next = next->left_ ? next->left_ : next->right_;
             }
         }
         else
@@ -556,16 +990,26 @@ PairingHeap<T, Compare, MergeMode, Allocator>::~PairingHeap()
 
     root_ = nullptr;
     size_ = 0;
+    this->free_blocks();
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::operator=(PairingHeap other
 ) noexcept -> PairingHeap&
 {
-    swap(*this, other);
+    this->swap(other);
     return *this;
 }
 
+template<class T, class Compare, class MergeMode, class Allocator>
+template<std::input_iterator InputIt>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::assign(
+    InputIt first, InputIt last
+) -> void
+{
+    *this = PairingHeap(first, last, alloc_);
+}
+
 template<class T, class Compare, class MergeMode, class Allocator>
 template<class... Args>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::emplace(Args&&... args)
@@ -589,10 +1033,34 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::insert(value_type&& value)
     return this->insert_impl(this->new_node(std::move(value)));
 }
 
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::insert_range(
+    std::span<value_type const> const values,
+    std::span<handle_type> const handles
+) -> void
+{
+    this->emplace_range(values, handles);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+template<class Arg>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::emplace_range(
+    std::span<Arg> const args, std::span<handle_type> const handles
+) -> void
+{
+    if (handles.size() < args.size())
+    {
+        throw std::invalid_argument("Not enough space for handles!");
+    }
+
+    this->insert_block(std::begin(args), args.size(), handles);
+}
+
 template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::delete_min() -> void
 {
     this->empty_check();
+    this->consolidate();
     auto* const oldRoot = root_;
 
     if (1 == this->size())
@@ -613,6 +1081,7 @@ template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::find_min() -> reference
 {
     this->empty_check();
+    this->consolidate();
     return root_->data_;
 }
 
@@ -621,6 +1090,7 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::find_min() const
     -> const_reference
 {
     this->empty_check();
+    this->consolidate();
     return root_->data_;
 }
 
@@ -648,14 +1118,52 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::decrease_key(
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::meld(PairingHeap other)
-    -> PairingHeap&
+auto PairingHeap<T, Compare, MergeMode, Allocator>::increase_key(
+    handle_type const handle
+) -> void
+{
+    this->inc_key_impl(handle_to_node(handle));
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::increase_key(iterator pos)
+    -> void
+{
+    this->inc_key_impl(pos.current_);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::increase_key(
+    const_iterator pos
+) -> void
+{
+    this->inc_key_impl(pos.current_);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::meld(PairingHeap other)
+    -> PairingHeap&
 {
     if (not root_ && not other.root_)
     {
         return *this;
     }
 
+    if constexpr (not node_alloc_traits::is_always_equal::value)
+    {
+        // Nodes of the other heap can't be deallocated by this allocator
+        if (alloc_ != other.alloc_)
+        {
+            for (auto& value : other)
+            {
+                this->insert(std::move(value));
+            }
+            return *this;
+        }
+    }
+
+    this->consolidate();
+    other.consolidate();
     auto* const otherRoot = std::exchange(other.root_, nullptr);
 
     if (root_ && otherRoot)
@@ -668,6 +1176,36 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::meld(PairingHeap other)
     }
 
     size_ += std::exchange(other.size_, 0);
+
+    // Blocks of the other heap must live as long as their nodes
+    if (not other.blocks_.empty())
+    {
+        auto const middle = blocks_.insert(
+            std::end(blocks_),
+            std::begin(other.blocks_),
+            std::end(other.blocks_)
+        );
+        std::inplace_merge(
+            std::begin(blocks_), middle, std::end(blocks_), block_less
+        );
+        other.blocks_.clear();
+    }
+
+    // Free nodes of the other heap go in front of these ones
+    if (other.freeNodes_)
+    {
+        if (freeNodes_)
+        {
+            next_free(other.freeTail_) = freeNodes_;
+        }
+        else
+        {
+            freeTail_ = other.freeTail_;
+        }
+        freeNodes_  = std::exchange(other.freeNodes_, nullptr);
+        freeCount_ += std::exchange(other.freeCount_, 0);
+    }
+
     return *this;
 }
 
@@ -682,14 +1220,14 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::erase(
 template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::erase(iterator pos) -> void
 {
-    this->erase_impl(pos.current());
+    this->erase_impl(pos.current_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::erase(const_iterator pos)
     -> void
 {
-    this->erase_impl(pos.current());
+    this->erase_impl(pos.current_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -699,6 +1237,10 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::swap(PairingHeap& other
     using std::swap;
     swap(root_, other.root_);
     swap(size_, other.size_);
+    swap(blocks_, other.blocks_);
+    swap(freeNodes_, other.freeNodes_);
+    swap(freeTail_, other.freeTail_);
+    swap(freeCount_, other.freeCount_);
 
     if constexpr (node_alloc_traits::propagate_on_container_swap::value)
     {
@@ -728,7 +1270,7 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::ssize() const
 template<class T, class Compare, class MergeMode, class Allocator>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::clear() -> void
 {
-    *this = PairingHeap();
+    *this = PairingHeap(alloc_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -810,7 +1352,15 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::delete_node(
     if (node)
     {
         node_alloc_traits::destroy(alloc_, node);
-        node_alloc_traits::deallocate(alloc_, node, 1);
+        // Most heaps have no blocks and skip the search.
+        if (not blocks_.empty() && this->is_in_block(node))
+        {
+            this->push_free(node);
+        }
+        else
+        {
+            node_alloc_traits::deallocate(alloc_, node, 1);
+        }
     }
 }
 
@@ -819,7 +1369,18 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::insert_impl(
     node_t* const node
 ) -> handle_type
 {
-    root_ = this->empty() ? node : pair(root_, node);
+    if (this->empty())
+    {
+        root_ = node;
+    }
+    else if constexpr (IsLazy)
+    {
+        this->push_aux(node);
+    }
+    else
+    {
+        root_ = pair(root_, node);
+    }
     ++size_;
     return handle_type(node);
 }
@@ -849,15 +1410,17 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::deep_copy(node_t* srcNode)
     {
         if (srcNode->left_ && not newNode->left_)
         {
-            newNode->left_ = this->copy_node(srcNode->left_);
-            srcNode        = srcNode->left_;
-            newNode        = newNode->left_;
+            newNode->left_          = this->copy_node(srcNode->left_);
+            newNode->left_->parent_ = newNode;
+            srcNode                 = srcNode->left_;
+            newNode                 = newNode->left_;
         }
         else if (srcNode->right_ && not newNode->right_)
         {
-            newNode->right_ = this->copy_node(srcNode->right_);
-            srcNode         = srcNode->right_;
-            newNode         = newNode->right_;
+            newNode->right_          = this->copy_node(srcNode->right_);
+            newNode->right_->parent_ = newNode;
+            srcNode                  = srcNode->right_;
+            newNode                  = newNode->right_;
         }
         else
         {
@@ -874,39 +1437,91 @@ auto PairingHeap<T, Compare, MergeMode, Allocator>::erase_impl(
     node_t* const node
 ) -> void
 {
+    this->consolidate();
     this->dec_key_impl<details::AlwaysTrueCmp>(node);
     this->delete_min();
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-template<class Cmp>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::dec_key_impl(
-    node_t* const node
+auto PairingHeap<T, Compare, MergeMode, Allocator>::push_aux(node_t* const node
 ) -> void
 {
-    if (node == root_)
+    node->parent_ = root_;
+    node->right_  = root_->right_;
+    if (node->right_)
     {
-        return;
+        node->right_->parent_ = node;
     }
+    root_->right_ = node;
+}
 
-    if (node->parent_ && node == node->parent_->left_)
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::consolidate() const
+    -> void
+{
+    if constexpr (IsLazy)
     {
-        node->parent_->left_ = node->right_;
+        if (root_ && root_->right_)
+        {
+            auto* const aux = root_->right_;
+            root_->right_   = nullptr;
+            aux->parent_    = nullptr;
+            root_ = pair(root_, merge(aux, merge_mode::Hierarchical()));
+        }
+    }
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::inc_key_impl(
+    node_t* const node
+) -> void
+{
+    this->consolidate();
+
+    if (node == root_)
+    {
+        root_ = nullptr;
     }
     else
     {
-        node->parent_->right_ = node->right_;
+        linker_t<>::cut(node);
     }
 
-    if (node->right_)
+    if (node->left_)
     {
-        node->right_->parent_ = node->parent_;
+        auto* const sons = std::exchange(node->left_, nullptr);
+        sons->parent_    = nullptr;
+        auto* const tree = merge(sons);
+        root_            = root_ ? pair(root_, tree) : tree;
     }
 
-    node->parent_ = nullptr;
-    node->right_  = nullptr;
+    root_ = root_ ? pair(root_, node) : node;
+}
 
-    root_         = pair<Cmp>(node, root_);
+template<class T, class Compare, class MergeMode, class Allocator>
+template<class Cmp>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::dec_key_impl(
+    node_t* const node
+) -> void
+{
+    if (node == root_)
+    {
+        return;
+    }
+
+    linker_t<>::cut(node);
+
+    if constexpr (IsLazy)
+    {
+        // Node waits in the auxiliary list if there is one
+        if (root_->right_)
+        {
+            this->push_aux(node);
+            return;
+        }
+    }
+
+    root_ = pair<Cmp>(node, root_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
@@ -914,164 +1529,226 @@ template<class... Args>
 auto PairingHeap<T, Compare, MergeMode, Allocator>::new_node_impl(Args&&... args
 ) -> node_t*
 {
-    auto const p = node_alloc_traits::allocate(alloc_, 1);
+    auto* p = static_cast<node_t*>(nullptr);
+    if (freeNodes_)
+    {
+        p = std::exchange(freeNodes_, next_free(freeNodes_));
+        --freeCount_;
+    }
+    else
+    {
+        p = node_alloc_traits::allocate(alloc_, 1);
+    }
     node_alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
     return p;
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::handle_to_node(
-    handle_type const handle
-) -> node_t*
-{
-    return static_cast<node_t*>(handle.node_);
-}
-
-template<class T, class Compare, class MergeMode, class Allocator>
-template<class Cmp>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::pair(
-    node_t* const lhs, node_t* const rhs
-) -> node_t*
+auto PairingHeap<T, Compare, MergeMode, Allocator>::reserve_nodes(
+    size_type const count
+) -> void
 {
-    auto const areOrdered  = Cmp()(lhs->data_, rhs->data_);
-    auto* const parent     = areOrdered ? lhs : rhs;
-    auto* const son        = areOrdered ? rhs : lhs;
-    auto* const oldLeftSon = parent->left_;
-
-    son->parent_           = parent;
-    son->right_            = oldLeftSon;
-    parent->left_          = son;
-
-    if (oldLeftSon)
+    if (freeCount_ >= count)
     {
-        oldLeftSon->parent_ = son;
+        return;
     }
 
-    return parent;
-}
+    auto const missing = count - freeCount_;
+    auto* const nodes  = node_alloc_traits::allocate(alloc_, missing);
+    auto const block   = NodeBlock {nodes, missing};
+    try
+    {
+        blocks_.insert(
+            std::upper_bound(
+                std::begin(blocks_), std::end(blocks_), block, block_less
+            ),
+            block
+        );
+    }
+    catch (...)
+    {
+        node_alloc_traits::deallocate(alloc_, nodes, missing);
+        throw;
+    }
 
-template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::merge(node_t* const first)
-    -> node_t*
-{
-    return merge(first, MergeMode());
+    // Pushed backwards so that they are taken in the order of addresses
+    for (auto i = missing; i > 0; --i)
+    {
+        this->push_free(nodes + i - 1);
+    }
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::merge(
-    node_t* const first, merge_mode::TwoPass
-) -> node_t*
+auto PairingHeap<T, Compare, MergeMode, Allocator>::push_free(
+    node_t* const node
+) -> void
 {
-    return second_pass(first_pass(first));
+    if (not freeNodes_)
+    {
+        freeTail_ = node;
+    }
+    ::new (static_cast<void*>(node)) node_t*(freeNodes_);
+    freeNodes_ = node;
+    ++freeCount_;
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::merge(
-    node_t* first, merge_mode::FifoQueue
-) -> node_t*
+template<std::input_iterator InputIt>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::insert_range_impl(
+    InputIt first, InputIt last
+) -> void
 {
-    // Use parent pointers to make the queue
-    auto* head    = first;
-    auto* last    = first;
-    first         = first->right_;
-    head->parent_ = nullptr;
-    head->right_  = nullptr;
-
-    auto* next    = static_cast<node_t*>(nullptr);
-    while (first)
+    if constexpr (std::forward_iterator<InputIt>)
     {
-        next           = first->right_;
-        first->right_  = nullptr;
-        first->parent_ = head;
-        head           = first;
-        first          = next;
+        auto const count = static_cast<size_type>(std::distance(first, last));
+        this->insert_block(first, count, {});
     }
-
-    // Perform fifo merge
-    while (head && head->parent_)
+    else
     {
-        auto* const lhs = head;
-        auto* const rhs = head->parent_;
-        head            = head->parent_->parent_;
-        lhs->parent_    = nullptr;
-        rhs->parent_    = nullptr;
-        last->parent_   = pair(lhs, rhs);
-        last            = last->parent_;
+        for (; first != last; ++first)
+        {
+            this->emplace(*first);
+        }
     }
-
-    return last;
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::first_pass(node_t* first)
-    -> node_t*
+template<std::forward_iterator ForwardIt>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::insert_block(
+    ForwardIt first, size_type const count, std::span<handle_type> const handles
+) -> void
 {
-    auto* prev   = static_cast<node_t*>(nullptr);
-    auto* paired = static_cast<node_t*>(nullptr);
-    auto* next   = first;
-    auto* second = first->right_;
+    if (0 == count)
+    {
+        return;
+    }
 
-    for (;;)
+    // Nodes are linked as a list of siblings
+    this->reserve_nodes(count);
+    auto* head = static_cast<node_t*>(nullptr);
+    auto* tail = static_cast<node_t*>(nullptr);
+    try
     {
-        first = next;
-        if (not first)
+        for (auto i = size_type(0); i < count; ++i, ++first)
         {
-            return prev;
-        }
+            auto* const node = this->new_node(*first);
+            if (tail)
+            {
+                tail->right_  = node;
+                node->parent_ = tail;
+            }
+            else
+            {
+                head = node;
+            }
+            tail = node;
 
-        second = first->right_;
-        if (second)
-        {
-            next            = second->right_;
-            first->right_   = nullptr;
-            first->parent_  = nullptr;
-            second->right_  = nullptr;
-            second->parent_ = nullptr;
-            paired          = pair(first, second);
+            if (i < handles.size())
+            {
+                handles[i] = handle_type(node);
+            }
         }
-        else
+    }
+    catch (...)
+    {
+        while (head)
         {
-            paired = first;
-            next   = nullptr;
+            this->delete_node(std::exchange(head, head->right_));
         }
+        throw;
+    }
 
-        if (prev)
-        {
-            prev->right_    = paired;
-            paired->parent_ = prev;
-        }
-        prev = paired;
+    auto* const tree = merge(head, merge_mode::FifoQueue());
+    if (this->empty())
+    {
+        root_ = tree;
+    }
+    else if constexpr (IsLazy)
+    {
+        this->push_aux(tree);
+    }
+    else
+    {
+        root_ = pair(root_, tree);
+    }
+    size_ += count;
+}
 
-        if (next)
-        {
-            next->parent_ = nullptr;
-        }
-        else
-        {
-            return prev;
-        }
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::is_in_block(
+    node_t* const node
+) const -> bool
+{
+    auto const less = std::less<node_t const*>();
+    auto const it   = std::upper_bound(
+        std::begin(blocks_),
+        std::end(blocks_),
+        NodeBlock {node, 0},
+        block_less
+    );
+
+    if (it == std::begin(blocks_))
+    {
+        return false;
     }
 
-    return prev; // TODO toto môže byť null, je to v poriadku?
+    auto const& block = *std::prev(it);
+    return less(node, block.nodes_ + block.count_);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
-auto PairingHeap<T, Compare, MergeMode, Allocator>::second_pass(node_t* last)
-    -> node_t*
+auto PairingHeap<T, Compare, MergeMode, Allocator>::block_less(
+    NodeBlock const& lhs, NodeBlock const& rhs
+) -> bool
 {
-    auto* const parent = last->parent_;
-    last->parent_      = nullptr;
+    return std::less<node_t const*>()(lhs.nodes_, rhs.nodes_);
+}
 
-    while (parent)
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::free_blocks() -> void
+{
+    for (auto const& block : blocks_)
     {
-        auto const next = parent->parent_;
-        parent->right_  = nullptr;
-        parent->parent_ = nullptr;
-        last            = pair(last, parent);
-        parent          = next;
+        node_alloc_traits::deallocate(alloc_, block.nodes_, block.count_);
     }
+    blocks_.clear();
+    freeNodes_ = nullptr;
+    freeTail_  = nullptr;
+    freeCount_ = 0;
+}
 
-    return last;
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::handle_to_node(
+    handle_type const handle
+) -> node_t*
+{
+    return static_cast<node_t*>(handle.node_);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::next_free(
+    node_t* const node
+) -> node_t*&
+{
+    return *std::launder(reinterpret_cast<node_t**>(node));
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+template<class Cmp>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::pair(
+    node_t* const lhs, node_t* const rhs
+) -> node_t*
+{
+    return linker_t<Cmp>::pair(lhs, rhs);
+}
+
+template<class T, class Compare, class MergeMode, class Allocator>
+template<class Mode>
+auto PairingHeap<T, Compare, MergeMode, Allocator>::merge(
+    node_t* const first, Mode const mode
+) -> node_t*
+{
+    return linker_t<>::merge(first, mode);
 }
 
 template<class T, class Compare, class MergeMode, class Allocator>
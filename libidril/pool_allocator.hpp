@@ -0,0 +1,341 @@
+#ifndef LIBIDRIL_POOL_ALLOCATOR_HPP
+#define LIBIDRIL_POOL_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace idril
+{
+namespace details
+{
+/**
+ *  \brief Pool of small blocks carved out of larger chunks.
+ *
+ *  Blocks of each size are kept in their own bin with its own free list.
+ *  A bin is created by the first allocation of its size, requests of
+ *  sizes that do not fit into any of the few bins are passed to the global
+ *  operator new. Chunks are aligned at least to the cache line and grow
+ *  geometrically. Freed blocks are reused in LIFO order. The pool is not
+ *  thread safe.
+ */
+class SlabPool
+{
+public:
+    SlabPool() = default;
+    SlabPool(SlabPool const&) = delete;
+    auto operator=(SlabPool const&) -> SlabPool& = delete;
+    ~SlabPool();
+
+    auto allocate(std::size_t size, std::size_t align) -> void*;
+    auto deallocate(void* block, std::size_t size, std::size_t align) -> void;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next_;
+    };
+
+    struct Chunk
+    {
+        std::byte* memory_;
+        std::size_t bytes_;
+        std::size_t align_;
+    };
+
+    /**
+     *  \brief Blocks of a single size.
+     */
+    struct Bin
+    {
+        std::size_t blockSize_ {0};
+        std::size_t blockAlign_ {0};
+        std::size_t chunkBlocks_ {0};
+        FreeBlock* freeList_ {nullptr};
+        std::byte* next_ {nullptr};
+        std::byte* end_ {nullptr};
+    };
+
+private:
+    static constexpr auto CacheLine      = std::size_t(64);
+    static constexpr auto FirstChunkSize = std::size_t(64);
+    static constexpr auto MaxChunkSize   = std::size_t(1) << 16;
+    static constexpr auto MaxBins        = std::size_t(4);
+
+private:
+    auto find_bin(std::size_t size, std::size_t align) -> Bin*;
+    auto new_chunk(Bin& bin) -> void;
+
+    static auto block_size(std::size_t size, std::size_t align)
+        -> std::size_t;
+
+private:
+    Bin bins_[MaxBins];
+    std::size_t binCount_ {0};
+    std::vector<Chunk> chunks_;
+};
+} // namespace details
+
+/**
+ *  \brief Allocator that serves single objects from a slab pool.
+ *
+ *  Arrays, i.e. requests of more than one object, are passed to the
+ *  global operator new.
+ *
+ *  Each default-constructed allocator owns a new pool. Copies and
+ *  rebound copies share it, so a container gets its own free list while
+ *  its internal node allocator still uses the same pool.
+ *  Copy-constructed containers get a new pool.
+ *
+ *  Allocators compare equal only if they share the pool. Containers that
+ *  should exchange nodes in O(1), e.g. by meld, must be constructed with
+ *  copies of the same allocator.
+ *
+ *  \tparam T  The type of the allocated objects.
+ */
+template<class T>
+class PoolAllocator
+{
+public:
+    template<class U>
+    friend class PoolAllocator;
+
+public:
+    using value_type                             = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::false_type;
+
+public:
+    /**
+     *  \brief Default constructor, creates new pool
+     */
+    PoolAllocator();
+
+    /**
+     *  \brief Copy constructor, shares the pool of \p other
+     *
+     *  There is no move constructor since moved-from containers must
+     *  still be able to allocate.
+     *
+     *  \param other allocator whose pool is shared
+     */
+    PoolAllocator(PoolAllocator const& other) noexcept = default;
+
+    /**
+     *  \brief Converting constructor, shares the pool of \p other
+     *  \param other allocator whose pool is shared
+     */
+    template<class U>
+    PoolAllocator(PoolAllocator<U> const& other) noexcept;
+
+    /**
+     *  \brief Allocates storage for \p n objects
+     *  \param n number of objects
+     *  \return pointer to the allocated storage
+     */
+    [[nodiscard]] auto allocate(std::size_t n) -> T*;
+
+    /**
+     *  \brief Deallocates storage for \p n objects
+     *  \param p pointer returned by allocate
+     *  \param n number of objects passed to allocate
+     */
+    auto deallocate(T* p, std::size_t n) -> void;
+
+    /**
+     *  \brief Returns allocator with a new pool for container copies
+     *  \return new allocator
+     */
+    auto select_on_container_copy_construction() const -> PoolAllocator;
+
+    template<class U>
+    auto operator==(PoolAllocator<U> const& other) const noexcept -> bool;
+
+    template<class U>
+    auto operator!=(PoolAllocator<U> const& other) const noexcept -> bool;
+
+private:
+    std::shared_ptr<details::SlabPool> pool_;
+};
+
+/// definitions:
+
+namespace details
+{
+inline SlabPool::~SlabPool()
+{
+    for (auto const& chunk : chunks_)
+    {
+        ::operator delete(
+            chunk.memory_, chunk.bytes_, std::align_val_t(chunk.align_)
+        );
+    }
+}
+
+inline auto SlabPool::allocate(std::size_t const size, std::size_t const align)
+    -> void*
+{
+    auto* const bin = this->find_bin(size, align);
+    if (not bin)
+    {
+        return ::operator new(size, std::align_val_t(align));
+    }
+
+    if (bin->freeList_)
+    {
+        auto* const block = bin->freeList_;
+        bin->freeList_    = bin->freeList_->next_;
+        return block;
+    }
+
+    if (bin->next_ == bin->end_)
+    {
+        this->new_chunk(*bin);
+    }
+
+    auto* const block = bin->next_;
+    bin->next_ += bin->blockSize_;
+    return block;
+}
+
+inline auto SlabPool::deallocate(
+    void* const block, std::size_t const size, std::size_t const align
+) -> void
+{
+    // Bins are never removed so the block comes from the bin of its size
+    // if there is one.
+    auto* const bin = this->find_bin(size, align);
+    if (not bin)
+    {
+        ::operator delete(block, size, std::align_val_t(align));
+        return;
+    }
+
+    bin->freeList_ = ::new (block) FreeBlock {bin->freeList_};
+}
+
+inline auto SlabPool::find_bin(std::size_t const size, std::size_t const align)
+    -> Bin*
+{
+    auto const blockSize = block_size(size, align);
+    for (auto i = std::size_t(0); i < binCount_; ++i)
+    {
+        if (bins_[i].blockSize_ == blockSize && bins_[i].blockAlign_ == align)
+        {
+            return &bins_[i];
+        }
+    }
+
+    if (binCount_ == MaxBins)
+    {
+        return nullptr;
+    }
+
+    auto& bin       = bins_[binCount_++];
+    bin.blockSize_  = blockSize;
+    bin.blockAlign_ = align;
+    return &bin;
+}
+
+inline auto SlabPool::new_chunk(Bin& bin) -> void
+{
+    // Chunks grow geometrically so that small pools stay small.
+    bin.chunkBlocks_   = 0 == bin.chunkBlocks_
+                           ? FirstChunkSize
+                           : std::min(MaxChunkSize, 2 * bin.chunkBlocks_);
+    auto const bytes   = bin.chunkBlocks_ * bin.blockSize_;
+    auto const align   = std::max(CacheLine, bin.blockAlign_);
+    auto* const memory = static_cast<std::byte*>(
+        ::operator new(bytes, std::align_val_t(align))
+    );
+    try
+    {
+        chunks_.push_back(Chunk {memory, bytes, align});
+    }
+    catch (...)
+    {
+        ::operator delete(memory, bytes, std::align_val_t(align));
+        throw;
+    }
+    bin.next_ = memory;
+    bin.end_  = memory + bytes;
+}
+
+inline auto SlabPool::block_size(std::size_t const size, std::size_t align)
+    -> std::size_t
+{
+    // Free blocks must be able to hold the link to the next one.
+    align = std::max(align, alignof(FreeBlock));
+    return (std::max(size, sizeof(FreeBlock)) + align - 1) / align * align;
+}
+} // namespace details
+
+template<class T>
+PoolAllocator<T>::PoolAllocator() :
+    pool_(std::make_shared<details::SlabPool>())
+{
+}
+
+template<class T>
+template<class U>
+PoolAllocator<T>::PoolAllocator(PoolAllocator<U> const& other) noexcept :
+    pool_(other.pool_)
+{
+}
+
+template<class T>
+auto PoolAllocator<T>::allocate(std::size_t const n) -> T*
+{
+    // Arrays of varying length would use up the bins of single objects.
+    if (1 != n)
+    {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(alignof(T)))
+        );
+    }
+
+    return static_cast<T*>(pool_->allocate(sizeof(T), alignof(T)));
+}
+
+template<class T>
+auto PoolAllocator<T>::deallocate(T* const p, std::size_t const n) -> void
+{
+    if (1 != n)
+    {
+        ::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+        return;
+    }
+
+    pool_->deallocate(p, sizeof(T), alignof(T));
+}
+
+template<class T>
+auto PoolAllocator<T>::select_on_container_copy_construction() const
+    -> PoolAllocator
+{
+    return PoolAllocator();
+}
+
+template<class T>
+template<class U>
+auto PoolAllocator<T>::operator==(PoolAllocator<U> const& other)
+    const noexcept -> bool
+{
+    return pool_ == other.pool_;
+}
+
+template<class T>
+template<class U>
+auto PoolAllocator<T>::operator!=(PoolAllocator<U> const& other)
+    const noexcept -> bool
+{
+    return not (*this == other);
+}
+} // namespace idril
+
+#endif